@@ -0,0 +1,406 @@
+//
+//  main.cpp
+//  EdgeBenchmark
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <cfloat>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../EdgeTracker/area.hpp"
+#include "../EdgeTracker/asm.hpp"
+#include "../EdgeTracker/lsq.hpp"
+#include "../EdgeTracker/models.hpp"
+#include "../EdgeTracker/orange.hpp"
+#include "../EdgeTracker/preprocess.hpp"
+#include "../EdgeTracker/region.hpp"
+#include "../EdgeTracker/synthetic.hpp"
+#include "../EdgeTracker/threadpool.hpp"
+#include "../EdgeTracker/tracker.hpp"
+
+using namespace std;
+using namespace cv;
+
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+//      Headless timings of the tracking kernels and of whole frames,
+//      over synthetic inputs so that runs are repeatable.
+//
+//      Usage: EdgeBenchmark [options]
+//          -w <n,n,...>    Whisker / point counts       (16,64,256)
+//          -d <d,d,...>    Edge densities, 0-1           (0.01,0.05,0.2)
+//          -s <WxH,...>    Frame sizes                   (640x480,1280x720,1920x1080)
+//          -n <n,n,...>    Objects per sequence          (1,3)
+//          -r <n>          Repetitions per kernel        (200)
+//          -f <n>          Frames per synthetic sequence (100)
+//          -k <name>       Only run kernels containing <name>
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+static vector<int> whiskerCounts = {16, 64, 256};
+static vector<double> edgeDensities = {0.01, 0.05, 0.2};
+static vector<Size> frameSizes = {Size(640, 480), Size(1280, 720), Size(1920, 1080)};
+static vector<int> objectCounts = {1, 3};
+static int reps = 200;
+static int numFrames = 100;
+static string filter = "";
+
+static const Vec6f BASE_POSE = Vec6f(0, 0, 400, -0.8, 0.1, 0.05);
+
+
+// * * * * * * * * * * * * * * *
+//      Helpers
+// * * * * * * * * * * * * * * *
+
+Mat planarPoints(int n) {
+    // n random points on the z=0 plane in homogeneous coords
+    Mat points = Mat(4, n, CV_32FC1);
+    randu(points.rowRange(0, 2), Scalar(-50), Scalar(50));
+    points.row(2).setTo(0);
+    points.row(3).setTo(1);
+    return points;
+}
+
+Mat edgeImage(Size size, double density) {
+    // An 8-bit image in which each pixel is an edge with the given probability
+    Mat noise = Mat(size, CV_32FC1);
+    randu(noise, Scalar(0), Scalar(1));
+    Mat edges;
+    threshold(noise, edges, 1 - density, 255, CV_THRESH_BINARY);
+    edges.convertTo(edges, CV_8UC1);
+    return edges;
+}
+
+vector<Whisker> randomWhiskers(Size size, int n) {
+    vector<Whisker> whiskers;
+    RNG rng(n);
+    for (int i = 0; i < n; i++) {
+        Point centre = Point(rng.uniform(0, size.width), rng.uniform(0, size.height));
+        double angle = rng.uniform(0.0, 2*CV_PI);
+        whiskers.push_back(Whisker(centre, Point2f(cos(angle), sin(angle)), Mat(4, 1, CV_32FC1, Scalar(1))));
+    }
+    return whiskers;
+}
+
+bool selected(string name) {
+    return filter.empty() || name.find(filter) != string::npos;
+}
+
+void benchmark(string name, string params, function<void()> kernel) {
+    // Prints the mean and fastest time of 'reps' calls to the kernel
+    if (!selected(name)) return;
+    
+    kernel();   // Warm up
+    double total = 0, fastest = DBL_MAX;
+    for (int r = 0; r < reps; r++) {
+        auto start = chrono::steady_clock::now();
+        kernel();
+        chrono::duration<double, micro> t = chrono::steady_clock::now() - start;
+        total += t.count();
+        fastest = min(fastest, t.count());
+    }
+    printf("%-22s %-24s %12.2f %12.2f\n", name.c_str(), params.c_str(), total / reps, fastest);
+}
+
+string sizeName(Size size) {
+    return to_string(size.width) + "x" + to_string(size.height);
+}
+
+
+// * * * * * * * * * * * * * * *
+//      Kernels
+// * * * * * * * * * * * * * * *
+
+void benchmarkKernels() {
+    printf("%-22s %-24s %12s %12s\n", "Kernel", "Parameters", "Mean (us)", "Min (us)");
+    
+    Mat K = SyntheticScene::intrinsics(Size(1280, 720));
+    
+    // Least squares, over the number of points
+    ThreadPool pool;
+    for (int n : whiskerCounts) {
+        Mat x = planarPoints(n);
+        Vec6f truePose = BASE_POSE;
+        Vec6f startPose = BASE_POSE + Vec6f(5, -5, 10, 0.05, -0.05, 0.05);
+        Mat target = lsq::projection(truePose, x, K).rowRange(0, 2).t();
+        string params = "points=" + to_string(n);
+        
+        benchmark("lsq::projection", params, [&] {lsq::projection(startPose, x, K);});
+        benchmark("lsq::jacobian", params, [&] {lsq::jacobian(SE3::fromPose(startPose), x, K);});
+        benchmark("lsq::poseEstimateLM", params, [&] {lsq::poseEstimateLM(startPose, x, target, K);});
+        benchmark("lsq::poseEstimateLM pool", params, [&] {lsq::poseEstimateLM(startPose, x, target, K, lsq::MAX_ITERATIONS, &pool);});
+    }
+    
+    // Pose algebra
+    Vec6f poseA = BASE_POSE, poseB = BASE_POSE + Vec6f(5, -5, 10, 0.05, -0.05, 0.05);
+    benchmark("lsq::relativePose", "", [&] {lsq::relativePose(poseA, poseB);});
+    benchmark("SE3 exp/log", "", [&] {SE3::exp(0.5 * SE3::fromPose(poseB).log());});
+    
+    // Edge search, over the frame size, edge density and number of whiskers
+    for (Size size : frameSizes) {
+        for (double d : edgeDensities) {
+            Mat canny = edgeImage(size, d);
+            Mat edges;
+            findNonZero(canny, edges);
+            BitEdgeMap bits;
+            bits.build(canny);
+            stringstream mapParams;
+            mapParams << sizeName(size) << " d=" << d;
+            benchmark("BitEdgeMap rows only", mapParams.str(), [&] {bits.setEdges(canny); bits.require(true, false);});
+            benchmark("BitEdgeMap cols only", mapParams.str(), [&] {bits.setEdges(canny); bits.require(false, true);});
+            benchmark("BitEdgeMap::build", mapParams.str(), [&] {bits.build(canny);});
+            for (int n : whiskerCounts) {
+                vector<Whisker> whiskers = randomWhiskers(size, n);
+                stringstream params;
+                params << sizeName(size) << " d=" << d << " n=" << n;
+                
+                benchmark("closestEdgePoint", params.str(), [&] {
+                    for (int w = 0; w < whiskers.size(); w++) whiskers[w].closestEdgePoint(edges);
+                });
+                benchmark("closestEdgePoint2", params.str(), [&] {
+                    for (int w = 0; w < whiskers.size(); w++) whiskers[w].closestEdgePoint2(canny);
+                });
+                benchmark("closestEdgePoint2 bits", params.str(), [&] {
+                    for (int w = 0; w < whiskers.size(); w++) whiskers[w].closestEdgePoint2(bits);
+                });
+                benchmark("edgeCandidates k=3", params.str(), [&] {
+                    for (int w = 0; w < whiskers.size(); w++) whiskers[w].edgeCandidates(canny, Mat(), 3);
+                });
+            }
+        }
+    }
+    
+    // Whisker projection, over the model (the whisker count follows from its size on screen)
+    vector<string> modelNames = {"Rect", "Dog", "House", "BlueBox"};
+    for (string name : modelNames) {
+        const Model * model = Model::byName(name).get();
+        Vec6f pose = BASE_POSE;
+        if (model->is3D) pose[2] = 1000;
+        int n = (int)ASM::projectToWhiskers(model, pose, K).size();
+        benchmark("ASM::projectToWhiskers", name + " n=" + to_string(n), [&] {ASM::projectToWhiskers(model, pose, K);});
+    }
+    
+    // Preprocessing, segmentation and area error, over the frame size
+    for (Size size : frameSizes) {
+        Mat Ks = SyntheticScene::intrinsics(size);
+        SyntheticScene scene = SyntheticScene(size, Ks);
+        scene.addObject("Dog", Trajectory(BASE_POSE));
+        scene.noise = 4;
+        const Model * model = scene.getModels()[0];
+        Mat frame;
+        vector<Vec6f> poses;
+        scene.render(0, frame, poses);
+        Mat seg = orange::segmentByColour(frame, model->colour);
+        Vec6f pose = BASE_POSE + Vec6f(3, -3, 5, 0.02, 0.02, 0.02);
+        
+        Mat blurred, canny, dilated, orientation, magnitude;
+        Mat cross = getStructuringElement(MORPH_CROSS, Size(3,3));
+        benchmark("blur+Canny+dilate", sizeName(size), [&] {
+            GaussianBlur(frame, blurred, Size(3,3), 1);
+            Canny(blurred, canny, 20, 60);
+            dilate(canny, dilated, cross);
+        });
+        benchmark("preprocess::edgeMap", sizeName(size), [&] {preprocess::edgeMap(frame, dilated, orientation, magnitude);});
+        benchmark("preprocess::colourEdgeMap", sizeName(size), [&] {preprocess::colourEdgeMap(frame, dilated, magnitude);});
+        benchmark("orange::segmentByColour", sizeName(size), [&] {orange::segmentByColour(frame, model->colour);});
+        benchmark("area::areaError", sizeName(size), [&] {area::areaError(pose, model, seg, Ks);});
+        Outline regionOutline = area::outline(seg);
+        benchmark("area::outline", sizeName(size), [&] {area::outline(seg);});
+        benchmark("area::areaError (polygon)", sizeName(size), [&] {area::areaError(pose, model, regionOutline, Ks);});
+        benchmark("area::gradient (polygon)", sizeName(size), [&] {area::gradient(pose, model, regionOutline, Ks);});
+        Mat sdf, sdfGradX, sdfGradY;
+        Mat outlinePts = region::outlinePoints(model);
+        benchmark("region::signedDistance", sizeName(size), [&] {region::signedDistance(seg, sdf, sdfGradX, sdfGradY);});
+        benchmark("region::refine", sizeName(size), [&] {region::refine(pose, outlinePts, Ks, sdf, sdfGradX, sdfGradY);});
+        Mat segEdges;
+        benchmark("HoughLinesP sweep", sizeName(size), [&] {
+            // As orange::borderLines used to: lower the threshold until 4 lines are found
+            Canny(seg, segEdges, 70, 210, 3, true);
+            vector<Vec4i> lines;
+            for (int threshold = 60; lines.size() < 4 && threshold > 0; threshold -= 5) HoughLinesP(segEdges, lines, 5, CV_PI/180, threshold, 50, 30);
+        });
+        benchmark("orange::borderLines", sizeName(size), [&] {orange::borderLines(seg);});
+    }
+}
+
+
+// * * * * * * * * * * * * * * *
+//      Polygon area checks
+// * * * * * * * * * * * * * * *
+
+void checkPolygonArea() {
+    // The analytic gradient of the polygon area error against central differences,
+    // and the polygon error against the pixel count, with the model in view and
+    // hanging half off the left of the frame
+    if (!selected("area::gradient")) return;
+    printf("\n%-22s %-24s %12s %12s %12s\n", "Area check", "Parameters", "Max rel diff", "Polygon (%)", "Pixels (%)");
+    Vec6f inView = BASE_POSE;
+    Vec6f offLeft = BASE_POSE;
+    offLeft[0] = -0.5 * BASE_POSE[2] / SyntheticScene::FOCAL_RATIO;
+    const float steps[6] = {0.1, 0.1, 0.1, 1e-3, 1e-3, 1e-3};     // mm, rad
+    
+    for (Size size : frameSizes) {
+        for (Vec6f truePose : {inView, offLeft}) {
+            string name = string(truePose == inView ? "Dog in view " : "Dog off left ") + sizeName(size);
+            Mat Ks = SyntheticScene::intrinsics(size);
+            SyntheticScene scene = SyntheticScene(size, Ks);
+            scene.addObject("Dog", Trajectory(truePose));
+            const Model * model = scene.getModels()[0];
+            Mat frame;
+            vector<Vec6f> poses;
+            scene.render(0, frame, poses);
+            Mat seg = orange::segmentByColour(frame, model->colour);
+            Outline region = area::outline(seg);
+            Vec6f pose = truePose + Vec6f(3, -3, 5, 0.02, 0.02, 0.02);
+            
+            Mat grad = area::gradient(pose, model, region, Ks);
+            double maxDiff = 0;
+            for (int i = 0; i < 6; i++) {
+                Vec6f twist = Vec6f(0, 0, 0, 0, 0, 0);
+                twist[i] = steps[i];
+                Vec6f plus = (SE3::exp(twist) * SE3::fromPose(pose)).toPose();
+                Vec6f minus = (SE3::exp(-twist) * SE3::fromPose(pose)).toPose();
+                double numeric = (area::areaError(plus, model, region, Ks) - area::areaError(minus, model, region, Ks)) / (2 * steps[i]);
+                double scale = max(fabs(numeric), (double)fabs(grad.at<float>(0, i)));
+                if (scale > 1e-6) maxDiff = max(maxDiff, fabs(grad.at<float>(0, i) - numeric) / scale);
+            }
+            printf("%-22s %-24s %12.4f %12.2f %12.2f\n", "area::gradient", name.c_str(), maxDiff,
+                   area::areaError(pose, model, region, Ks), area::areaError(pose, model, seg, Ks));
+        }
+    }
+}
+
+
+// * * * * * * * * * * * * * * *
+//      Initialisation
+// * * * * * * * * * * * * * * *
+
+void benchmarkInitialisation() {
+    // Starting poses of planar models found without templates, from the centroid
+    // and area alone or from the lines around them too
+    printf("\n%-22s %-24s %12s %12s %12s %12s\n", "Initialiser", "Parameters", "Time (ms)", "Source", "Error (mm)", "Error (deg)");
+    Vec6f truePose = Vec6f(15, -10, 350, -0.5, 0.2, 0.6);
+    
+    for (Size size : frameSizes) {
+        for (string name : {"Rect", "Triangle", "Diamond", "Dog"}) {
+            Mat Ks = SyntheticScene::intrinsics(size);
+            SyntheticScene scene = SyntheticScene(size, Ks);
+            scene.addObject(name, Trajectory(truePose));
+            scene.noise = 4;
+            Mat frame;
+            vector<Vec6f> poses;
+            scene.render(0, frame, poses);
+            
+            for (bool lines : {false, true}) {
+                string method = lines ? "Tracker lines" : "Tracker centroid";
+                if (!selected(method)) continue;
+                Tracker tracker = Tracker(scene.getModels(), Ks);
+                tracker.useLineInit = lines;
+                auto start = chrono::steady_clock::now();
+                tracker.initialise(frame);
+                double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+                
+                Vec6f d = tracker.getEstimates()[0].pose - poses[0];
+                Vec6f rel = lsq::relativePose(poses[0], tracker.getEstimates()[0].pose);
+                double angle = norm(Vec3f(rel[3], rel[4], rel[5])) * 180 / CV_PI;
+                printf("%-22s %-24s %12.3f %12s %12.2f %12.2f\n", method.c_str(), (name + " " + sizeName(size)).c_str(), ms,
+                       tracker.getInitSources()[0].c_str(), sqrt(d[0]*d[0] + d[1]*d[1] + d[2]*d[2]), angle);
+            }
+        }
+    }
+}
+
+
+// * * * * * * * * * * * * * * *
+//      End-to-end
+// * * * * * * * * * * * * * * *
+
+void benchmarkSequences() {
+    printf("\n%-22s %-24s %12s %12s\n", "Sequence", "Parameters", "fps", "Error (mm)");
+    
+    for (Size size : frameSizes) {
+        for (int n : objectCounts) {
+            string name = to_string(n) + (n == 1 ? " object" : " objects");
+            if (!selected(name)) continue;
+            
+            SyntheticScene scene = SyntheticScene::random(size, n);
+            scene.noise = 4;
+            vector<const Model *> models = scene.getModels();
+            Mat K = scene.getK();
+            
+            // Render the whole sequence first so that only tracking is timed
+            vector<Mat> frames(numFrames);
+            vector<vector<Vec6f>> truth(numFrames);
+            for (int f = 0; f < numFrames; f++) scene.render(f, frames[f], truth[f]);
+            
+            vector<estimate> est;
+            for (int m = 0; m < models.size(); m++) est.push_back(estimate(truth[0][m], 0, 0));
+            Tracker tracker = Tracker(models, K, est);
+            
+            double error = 0;
+            auto start = chrono::steady_clock::now();
+            for (int f = 0; f < numFrames; f++) {
+                tracker.processFrame(frames[f]);
+                est = tracker.getEstimates();
+                for (int m = 0; m < models.size(); m++) {
+                    Vec6f d = est[m].pose - truth[f][m];
+                    error += sqrt(d[0]*d[0] + d[1]*d[1] + d[2]*d[2]);
+                }
+            }
+            chrono::duration<double> duration = chrono::steady_clock::now() - start;
+            
+            printf("%-22s %-24s %12.1f %12.2f\n", name.c_str(), sizeName(size).c_str(),
+                   numFrames / duration.count(), error / (numFrames * models.size()));
+        }
+    }
+}
+
+
+// * * * * * * * * * * * * * * *
+//      Main
+// * * * * * * * * * * * * * * *
+
+template <typename T>
+vector<T> parseList(string arg, function<T(string)> parse) {
+    vector<T> ret;
+    stringstream ss(arg);
+    string item;
+    while (getline(ss, item, ',')) ret.push_back(parse(item));
+    return ret;
+}
+
+int main(int argc, const char * argv[]) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string arg = argv[i];
+        string value = argv[i+1];
+        if (arg == "-w") whiskerCounts = parseList<int>(value, [](string s) {return stoi(s);});
+        else if (arg == "-d") edgeDensities = parseList<double>(value, [](string s) {return stod(s);});
+        else if (arg == "-s") frameSizes = parseList<Size>(value, [](string s) {
+            size_t x = s.find('x');
+            return Size(stoi(s.substr(0, x)), stoi(s.substr(x + 1)));
+        });
+        else if (arg == "-n") objectCounts = parseList<int>(value, [](string s) {return stoi(s);});
+        else if (arg == "-r") reps = stoi(value);
+        else if (arg == "-f") numFrames = stoi(value);
+        else if (arg == "-k") filter = value;
+        else {
+            cout << "Unknown option " << arg << endl;
+            return -1;
+        }
+    }
+    
+    theRNG().state = 1;
+    benchmarkKernels();
+    checkPolygonArea();
+    benchmarkInitialisation();
+    benchmarkSequences();
+    
+    return 0;
+}
@@ -6,10 +6,13 @@
 //  Copyright © 2018 Daniel Mesham. All rights reserved.
 //
 
+#include <algorithm>
+#include <cfloat>
+
 #include "area.hpp"
 
 
-double area::areaError(Vec6f pose, Model * model, Mat img, Mat K) {
+double area::areaError(Vec6f pose, const Model * model, Mat img, Mat K) {
     // Count the number of pixels in the model projection
     Mat modelProj = Mat(img.rows, img.cols, CV_8UC1, Scalar(0));
     model->draw(modelProj, pose, K, false, Scalar(255));
@@ -33,7 +36,7 @@ double area::areaError(Vec6f pose, Model * model, Mat img, Mat K) {
     return 100.0 * XOR / OR;
 }
 
-Mat area::jacobian(Vec6f pose, Model * model, Mat img, Mat K) {
+Mat area::jacobian(Vec6f pose, const Model * model, Mat img, Mat K) {
     // Calculates the Jacobian for the given pose of model x
     //Mat J = Mat(1, 0, CV_32FC1);
     vector<double> J = {};
@@ -60,7 +63,7 @@ Mat area::jacobian(Vec6f pose, Model * model, Mat img, Mat K) {
 
 
 
-estimate area::poseEstimateArea(Vec6f pose1, Model * model, Mat img, Mat K, int maxIter) {
+estimate area::poseEstimateArea(Vec6f pose1, const Model * model, Mat img, Mat K, int maxIter) {
     // pose1: imitial pose parameters
     // model: model to be matched
     // img: segmented image mask
@@ -92,7 +95,7 @@ estimate area::poseEstimateArea(Vec6f pose1, Model * model, Mat img, Mat K, int
     return estimate(pose1, E, iterations);
 }
 
-double area::unexplainedArea(Vec6f pose, Model * model, Mat img, Mat K) {
+double area::unexplainedArea(Vec6f pose, const Model * model, Mat img, Mat K) {
     // Counts the percentage of the image pixels (in 'img') not explained by the
     // model when in the given pose.
     
@@ -115,3 +118,283 @@ double area::unexplainedArea(Vec6f pose, Model * model, Mat img, Mat K) {
     return 100.0 * numUnexplainedPixels / numImagePixels;
 }
 
+
+// * * * * * * * * * * * * * * *
+//      Polygon area error
+// * * * * * * * * * * * * * * *
+
+static inline float cross2(Point2f a, Point2f b) {return a.x*b.y - a.y*b.x;}
+
+static void addSegment(Outline & outline, Point2f p, Point2f q, Point2f inside) {
+    // Adds the segment pq, turned so that the point 'inside' is on its right
+    if (cross2(q - p, inside - p) < 0) swap(p, q);
+    outline.segments.push_back(Vec4f(p.x, p.y, q.x, q.y));
+}
+
+static void finishOutline(Outline & outline) {
+    // The bounds and area (by Green's theorem) of the segments
+    float x0 = FLT_MAX, y0 = FLT_MAX, x1 = -FLT_MAX, y1 = -FLT_MAX;
+    outline.area = 0;
+    for (const Vec4f & s : outline.segments) {
+        x0 = min(x0, min(s[0], s[2]));
+        y0 = min(y0, min(s[1], s[3]));
+        x1 = max(x1, max(s[0], s[2]));
+        y1 = max(y1, max(s[1], s[3]));
+        outline.area += 0.5 * (s[0]*s[3] - s[2]*s[1]);
+    }
+    outline.bounds = outline.segments.empty() ? Rect2f() : Rect2f(x0, y0, x1 - x0, y1 - y0);
+}
+
+static bool overlaps(const Vec4f & s, const Rect2f & r) {
+    // Whether the bounding box of segment s overlaps r
+    return max(s[0], s[2]) >= r.x && min(s[0], s[2]) <= r.x + r.width &&
+           max(s[1], s[3]) >= r.y && min(s[1], s[3]) <= r.y + r.height;
+}
+
+static bool inside(Point2f p, const Outline & outline) {
+    // Even-odd test: whether a ray from p to the right crosses the outline an odd no. of times
+    if (!outline.bounds.contains(p)) return false;
+    bool in = false;
+    for (const Vec4f & s : outline.segments) {
+        if ((s[1] > p.y) == (s[3] > p.y)) continue;
+        float x = s[0] + (p.y - s[1]) * (s[2] - s[0]) / (s[3] - s[1]);
+        if (x > p.x) in = !in;
+    }
+    return in;
+}
+
+static double boundaryInside(const Outline & edges, const Outline & other, vector<Vec2f> * weights = NULL) {
+    // Half the sum of cross(p, q) over the parts pq of the segments of 'edges' that are
+    // inside 'other': their share of the area of the intersection (by Green's theorem).
+    // weights: for each segment, the integrals of (1 - t) and t over its inside parts,
+    // where t runs from 0 at its start to 1 at its end (for the gradient)
+    if (weights != NULL) weights->assign(edges.segments.size(), Vec2f(0, 0));
+    double sum = 0;
+    vector<float> cuts;
+    
+    for (int i = 0; i < edges.segments.size(); i++) {
+        const Vec4f & e = edges.segments[i];
+        if (!overlaps(e, other.bounds)) continue;
+        Point2f p = Point2f(e[0], e[1]), r = Point2f(e[2] - e[0], e[3] - e[1]);
+        
+        // Split it where it crosses the other outline
+        cuts.assign({0, 1});
+        for (const Vec4f & o : other.segments) {
+            if (!overlaps(o, Rect2f(min(e[0], e[2]), min(e[1], e[3]), fabs(r.x), fabs(r.y)))) continue;
+            Point2f c = Point2f(o[0], o[1]), s = Point2f(o[2] - o[0], o[3] - o[1]);
+            float denom = cross2(r, s);
+            if (denom == 0) continue;
+            float t = cross2(c - p, s) / denom;
+            float u = cross2(c - p, r) / denom;
+            if (t > 0 && t < 1 && u >= 0 && u <= 1) cuts.push_back(t);
+        }
+        sort(cuts.begin(), cuts.end());
+        
+        // Keep the pieces whose midpoints are inside
+        float crossPQ = cross2(p, p + r);
+        for (int k = 0; k + 1 < cuts.size(); k++) {
+            float t0 = cuts[k], t1 = cuts[k + 1];
+            if (t1 <= t0 || !inside(p + 0.5f*(t0 + t1)*r, other)) continue;
+            sum += 0.5 * (t1 - t0) * crossPQ;
+            if (weights != NULL) {
+                float half = 0.5f * (t1*t1 - t0*t0);
+                (*weights)[i] += Vec2f(t1 - t0 - half, half);
+            }
+        }
+    }
+    return sum;
+}
+
+class EdgePiece {
+public:
+    int v0 = -1, v1 = -1;   // The model edge (from vertex v0 to v1) a segment lies along; -1: the frame's border
+    float a = 0, b = 1;     // The part of that edge it covers (0 at v0, 1 at v1)
+};
+
+class ClipVertex {
+public:
+    Point2f p;
+    int edge;               // The model edge along which the segment from here runs (-1: the frame's border)
+    float s;                // Where this vertex is along that edge
+};
+
+static float along(Point2f p, Point2f a, Point2f b) {
+    // Where p is along ab (0 at a, 1 at b)
+    Point2f d = b - a;
+    float length2 = d.dot(d);
+    return length2 > 0 ? (p - a).dot(d) / length2 : 0;
+}
+
+static Outline modelOutline(Vec6f pose, const Model * model, Mat K, Size frame, vector<EdgePiece> & pieces) {
+    // The projected outline of a planar model (its vertices are in order around it),
+    // turned to match the region outlines and clipped to the frame as the region is
+    // (the region's outline runs half a pixel outside the border pixels; the clip is
+    // a hair inside that, so the two never share an edge).
+    // pieces: for each segment, the part of the model edge it lies along
+    Mat proj = lsq::projection(pose, model->pointsToMat(), K);
+    int n = proj.cols;
+    vector<Point2f> points(n);
+    double signedArea = 0;
+    for (int i = 0; i < n; i++) points[i] = Point2f(proj.at<float>(0, i), proj.at<float>(1, i));
+    for (int i = 0; i < n; i++) signedArea += cross2(points[i], points[(i + 1) % n]);
+    
+    // Edge i runs from vertex order[i] to order[i + 1]
+    vector<int> order(n);
+    for (int i = 0; i < n; i++) order[i] = (signedArea >= 0) ? i : n - 1 - i;
+    vector<ClipVertex> poly(n);
+    for (int i = 0; i < n; i++) poly[i] = {points[order[i]], i, 0};
+    
+    // Sutherland-Hodgman, against each side of the frame in turn (inside: dot(normal, p) <= limit)
+    const float EPS = 1e-3;
+    Vec3f sides[4] = {Vec3f(-1, 0, 0.5f - EPS), Vec3f(1, 0, frame.width - 0.5f - EPS),
+                      Vec3f(0, -1, 0.5f - EPS), Vec3f(0, 1, frame.height - 0.5f - EPS)};
+    vector<ClipVertex> clipped;
+    for (const Vec3f & side : sides) {
+        clipped.clear();
+        for (int k = 0; k < poly.size(); k++) {
+            const ClipVertex & P = poly[k];
+            const ClipVertex & Q = poly[(k + 1) % poly.size()];
+            float dP = side[0]*P.p.x + side[1]*P.p.y - side[2];
+            float dQ = side[0]*Q.p.x + side[1]*Q.p.y - side[2];
+            if ((dP <= 0) != (dQ <= 0)) {
+                // Where PQ crosses the side: from there it runs on along PQ if entering,
+                // else along the border until it comes back in
+                Point2f I = P.p + (dP / (dP - dQ)) * (Q.p - P.p);
+                int edge = (dP > 0) ? P.edge : -1;
+                float s = 0;
+                if (edge >= 0) s = along(I, points[order[edge]], points[order[(edge + 1) % n]]);
+                clipped.push_back({I, edge, s});
+            }
+            if (dQ <= 0) clipped.push_back(Q);
+        }
+        poly.swap(clipped);
+        if (poly.empty()) break;
+    }
+    
+    Outline outline;
+    pieces.clear();
+    for (int k = 0; k < poly.size(); k++) {
+        const ClipVertex & P = poly[k];
+        const ClipVertex & Q = poly[(k + 1) % poly.size()];
+        outline.segments.push_back(Vec4f(P.p.x, P.p.y, Q.p.x, Q.p.y));
+        EdgePiece piece;
+        if (P.edge >= 0) {
+            piece.v0 = order[P.edge];
+            piece.v1 = order[(P.edge + 1) % n];
+            piece.a = P.s;
+            piece.b = along(Q.p, points[piece.v0], points[piece.v1]);
+        }
+        pieces.push_back(piece);
+    }
+    finishOutline(outline);
+    return outline;
+}
+
+Outline area::outline(Mat img) {
+    // The boundary of the non-zero pixels of 'img' (e.g. from orange::segmentByColour),
+    // as directed segments between the midpoints of neighbouring inside and outside
+    // pixels (marching squares). Extract it once per frame, then measure any number
+    // of poses against it.
+    Mat mask = img;
+    if (img.channels() == 3) cvtColor(img, mask, CV_BGR2GRAY);
+    Outline outline;
+    outline.frame = mask.size();
+    
+    // Each cell has pixel centres a, b, c, d at its corners (clockwise from the top left),
+    // and cells hang half off the frame so that the outline is closed at its borders.
+    // Edge k of the cell runs from corner k to corner k+1.
+    for (int y = -1; y < mask.rows; y++) {
+        const uchar * row0 = (y >= 0) ? mask.ptr<uchar>(y) : NULL;
+        const uchar * row1 = (y + 1 < mask.rows) ? mask.ptr<uchar>(y + 1) : NULL;
+        for (int x = -1; x < mask.cols; x++) {
+            bool left = x >= 0, right = x + 1 < mask.cols;
+            bool in[4] = {
+                row0 != NULL && left && row0[x] != 0,
+                row0 != NULL && right && row0[x + 1] != 0,
+                row1 != NULL && right && row1[x + 1] != 0,
+                row1 != NULL && left && row1[x] != 0
+            };
+            int numIn = in[0] + in[1] + in[2] + in[3];
+            if (numIn == 0 || numIn == 4) continue;
+            
+            Point2f corner[4] = {Point2f(x, y), Point2f(x + 1, y), Point2f(x + 1, y + 1), Point2f(x, y + 1)};
+            Point2f mid[4] = {Point2f(x + 0.5f, y), Point2f(x + 1, y + 0.5f), Point2f(x + 0.5f, y + 1), Point2f(x, y + 0.5f)};
+            
+            if (numIn == 2 && in[0] == in[2]) {
+                // Diagonal: the inside pixels are joined (as 8-connected), cutting off the outside corners
+                Point2f centre = Point2f(x + 0.5f, y + 0.5f);
+                for (int k = 0; k < 4; k++) if (!in[k]) addSegment(outline, mid[(k + 3) % 4], mid[k], centre);
+            }
+            else if (numIn == 2) {
+                // Side by side: the segment crosses the two edges between them
+                int e[2], numEdges = 0, inCorner = in[0] ? 0 : 2;
+                for (int k = 0; k < 4; k++) if (in[k] != in[(k + 1) % 4]) e[numEdges++] = k;
+                addSegment(outline, mid[e[0]], mid[e[1]], corner[inCorner]);
+            }
+            else {
+                // One corner differs from the rest: cut it off
+                int k = 0;
+                while (in[k] == (numIn == 3)) k++;
+                addSegment(outline, mid[(k + 3) % 4], mid[k], numIn == 1 ? corner[k] : corner[(k + 2) % 4]);
+            }
+        }
+    }
+    
+    finishOutline(outline);
+    return outline;
+}
+
+double area::areaError(Vec6f pose, const Model * model, const Outline & region, Mat K) {
+    // As areaError, for a planar model, but from the overlap of its projected polygon
+    // with the region's outline. This is exact to sub-pixel precision, and changes
+    // smoothly with the pose. Like the pixel count, it only counts what is in the frame.
+    vector<EdgePiece> pieces;
+    Outline projected = modelOutline(pose, model, K, region.frame, pieces);
+    double intersection = boundaryInside(projected, region) + boundaryInside(region, projected);
+    double OR = projected.area + region.area - intersection;
+    if (OR <= 0) return 0;
+    return 100.0 * (OR - intersection) / OR;
+}
+
+Mat area::gradient(Vec6f pose, const Model * model, const Outline & region, Mat K) {
+    // The gradient (1x6) of the polygon area error with respect to a twist applied to the
+    // pose (see se3.hpp). Only the model's edges move, so by the Reynolds transport theorem
+    // the areas change by the flux of each edge's motion through the parts of it that count.
+    // The frame's border doesn't move, and its ends only slide along it, so it adds nothing.
+    vector<EdgePiece> pieces;
+    Outline projected = modelOutline(pose, model, K, region.frame, pieces);
+    vector<Vec2f> weights;
+    double intersection = boundaryInside(projected, region, &weights) + boundaryInside(region, projected);
+    double OR = projected.area + region.area - intersection;
+    Mat grad = Mat::zeros(1, 6, CV_32FC1);
+    if (OR <= 0) return grad;
+    
+    // d(area)/d(vertex) of the intersection and the whole model, from each edge's outward normal.
+    // A segment covering [a, b] of its model edge moves with the edge's vertices in the
+    // proportions (1 - s, s), where s = a + (b - a) t along the segment.
+    int n = model->pointsToMat().cols;
+    vector<Vec2f> dI(n, Vec2f(0, 0)), dM(n, Vec2f(0, 0));
+    for (int i = 0; i < pieces.size(); i++) {
+        const EdgePiece & e = pieces[i];
+        if (e.v0 < 0) continue;
+        const Vec4f & s = projected.segments[i];
+        Vec2f normal = Vec2f(s[3] - s[1], s[0] - s[2]);
+        float span = e.b - e.a;
+        float wI = weights[i][0] + weights[i][1];
+        float wI1 = e.a * wI + span * weights[i][1];
+        float wM1 = e.a + 0.5f * span;
+        dI[e.v0] += (wI - wI1) * normal;
+        dI[e.v1] += wI1 * normal;
+        dM[e.v0] += (1 - wM1) * normal;
+        dM[e.v1] += wM1 * normal;
+    }
+    
+    // E = 100 * (1 - I / OR), where OR = M + R - I
+    Mat J = lsq::jacobian(SE3::fromPose(pose), model->pointsToMat(), K);
+    for (int v = 0; v < n; v++) {
+        Vec2f dOR = dM[v] - dI[v];
+        Vec2f dE = -100.0f * (float)(1 / OR) * (dI[v] - (float)(intersection / OR) * dOR);
+        grad += dE[0] * J.row(2*v) + dE[1] * J.row(2*v + 1);
+    }
+    return grad;
+}
@@ -16,6 +16,19 @@
 #include "lsq.hpp"
 #include "models.hpp"
 
+// * * * * * * * * * * * * * * *
+//      Outline
+// * * * * * * * * * * * * * * *
+
+class Outline {
+public:
+    vector<Vec4f> segments;     // (x1, y1, x2, y2), each with the region on its right (y down)
+    Rect2f bounds;
+    double area = 0;            // Enclosed area (px^2)
+    Size frame;                 // Of the image it came from (region outlines only)
+};
+
+
 // * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
 //      A library of area matching methods
 // * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
@@ -25,10 +38,15 @@ class area {
  METHODS
  */
 public:
-    static double areaError(Vec6f pose, Model * model, Mat img, Mat K);
-    static Mat jacobian(Vec6f pose, Model * model, Mat img, Mat K);
-    static estimate poseEstimateArea(Vec6f pose1, Model * model, Mat img, Mat K, int maxIter = MAX_ITERATIONS);
-    static double unexplainedArea(Vec6f pose, Model * model, Mat img, Mat K);
+    static double areaError(Vec6f pose, const Model * model, Mat img, Mat K);
+    static Mat jacobian(Vec6f pose, const Model * model, Mat img, Mat K);
+    static estimate poseEstimateArea(Vec6f pose1, const Model * model, Mat img, Mat K, int maxIter = MAX_ITERATIONS);
+    static double unexplainedArea(Vec6f pose, const Model * model, Mat img, Mat K);
+    
+    // Planar models only: exact polygon geometry instead of counting pixels
+    static Outline outline(Mat img);
+    static double areaError(Vec6f pose, const Model * model, const Outline & region, Mat K);
+    static Mat gradient(Vec6f pose, const Model * model, const Outline & region, Mat K);
 
 /*
  CONSTANTS
@@ -6,6 +6,8 @@
 //  Copyright © 2018 Daniel Mesham. All rights reserved.
 //
 
+#include <algorithm>
+
 #include "asm.hpp"
 
 
@@ -42,6 +44,8 @@ Point Whisker::closestEdgePoint(Mat edges, int maxDist) {
 }
 
 Point Whisker::closestEdgePoint2(Mat canny, int maxDist) {
+    // canny: (dilated) edge map, one byte per pixel, where any non-zero value is an edge.
+    //        This includes packed colour edge maps (see preprocess::colourEdgeMap).
     Point endPos = centre + Point(maxDist*normal.x, maxDist*normal.y);
     Point endNeg = centre - Point(maxDist*normal.x, maxDist*normal.y);
     if (centre.x < 0 || centre.y < 0 || centre.x >= canny.cols || centre.y >= canny.rows) return Point(-1,-1);
@@ -60,31 +64,172 @@ Point Whisker::closestEdgePoint2(Mat canny, int maxDist) {
     return Point(-1,-1);
 }
 
-Point Whisker::closestEdgePoint2(Mat canny[3], int maxDist) {
+Point Whisker::closestEdgePoint2(const BitEdgeMap & edges, int maxDist) {
+    // The same search as above on a bit-packed edge map, a run of pixels at a time.
+    // Each side follows the same pixels as its LineIterator above (clipped to the
+    // image), and both stop after as many pixels as the shorter side has.
+    if (centre.x < 0 || centre.y < 0 || centre.x >= edges.getWidth() || centre.y >= edges.getHeight()) return Point(-1,-1);
+    if (edges.test(centre.x, centre.y)) return centre;
+    
+    Size size = Size(edges.getWidth(), edges.getHeight());
+    Point start = centre;
     Point endPos = centre + Point(maxDist*normal.x, maxDist*normal.y);
     Point endNeg = centre - Point(maxDist*normal.x, maxDist*normal.y);
-    if (centre.x < 0 || centre.y < 0 || centre.x >= canny[0].cols || centre.y >= canny[0].rows) return Point(-1,-1);
-    if (canny[0].at<uchar>(centre) > 0) return centre;
-    if (canny[1].at<uchar>(centre) > 0) return centre;
-    if (canny[2].at<uchar>(centre) > 0) return centre;
+    clipLine(size, start, endPos);
+    clipLine(size, start, endNeg);
+    Point dPos = endPos - centre, dNeg = endNeg - centre;
+    int steps = min(max(abs(dPos.x), abs(dPos.y)), max(abs(dNeg.x), abs(dNeg.y)));
     
-    LineIterator liPos(canny[0], centre, endPos);
-    LineIterator liNeg(canny[0], centre, endNeg);
-    for (int i = 0; i < MIN(liPos.count, liNeg.count); i++, ++liPos, ++liNeg) {
-        if ((canny[0].at<uchar>(liPos.pos()) > 0) ||
-            (canny[1].at<uchar>(liPos.pos()) > 0) ||
-            (canny[2].at<uchar>(liPos.pos()) > 0)) {
-            // If exactly in between 2 edges, discard this whisker
-            if ((canny[0].at<uchar>(liNeg.pos()) > 0) ||
-                (canny[1].at<uchar>(liNeg.pos()) > 0) ||
-                (canny[2].at<uchar>(liNeg.pos()) > 0)) return Point(-1,-1);
-            return liPos.pos();
+    Point hitPos, hitNeg;
+    int pos = firstEdge(edges, endPos, steps, hitPos);
+    int neg = firstEdge(edges, endNeg, steps, hitNeg);
+    if (pos < 0 && neg < 0) return Point(-1,-1);
+    if (neg < 0 || (pos >= 0 && pos < neg)) return hitPos;
+    if (pos < 0 || neg < pos) return hitNeg;
+    
+    // If exactly in between 2 edges, discard this whisker
+    return Point(-1,-1);
+}
+
+bool Whisker::searchesRows(int maxDist) const {
+    // Whether the bit-packed search scans rows (else columns), i.e. the whisker
+    // is at most 45 degrees from horizontal
+    Point d = Point(maxDist*normal.x, maxDist*normal.y);
+    return abs(d.x) >= abs(d.y);
+}
+
+int Whisker::firstEdge(const BitEdgeMap & edges, Point end, int steps, Point & hit) {
+    // Finds the first edge on the line from the centre to 'end', within 'steps' pixels.
+    // Returns the number of pixels along the line to it, or -1 if none.
+    // The pixels are those a LineIterator visits (8-connected Bresenham): a line at most
+    // 45 degrees from horizontal is made of horizontal runs, one per row it crosses,
+    // and each run is searched with one row scan (likewise steeper lines and columns).
+    Point d = end - centre;
+    bool horizontal = abs(d.x) >= abs(d.y);
+    int dx = horizontal ? abs(d.x) : abs(d.y);      // Along the major axis
+    int dy = horizontal ? abs(d.y) : abs(d.x);      // Along the minor axis
+    int dir = (horizontal ? d.x : d.y) < 0 ? -1 : 1;
+    int minorDir = (horizontal ? d.y : d.x) < 0 ? -1 : 1;
+    int c0 = horizontal ? centre.x : centre.y;
+    int c1 = horizontal ? centre.y : centre.x;
+    steps = min(steps, dx);
+    
+    // LineIterator's error term: the pixel after one where err < 0 is a step along the minor axis
+    int err = dx - 2*dy;
+    int offset = 0;
+    for (int i = 0; i < steps; ) {
+        // Move to the next pixel
+        if (err < 0) {
+            offset += minorDir;
+            err += 2*(dx - dy);
+        }
+        else err -= 2*dy;
+        i++;
+        
+        // The run of pixels [i, j] in its row (or column): it continues while err >= 0
+        int j = steps;
+        if (dy > 0) j = err < 0 ? i : min(steps, i + err / (2*dy) + 1);
+        
+        int found;
+        if (horizontal) found = edges.scanRow(c1 + offset, c0 + dir*i, dir, j - i + 1);
+        else found = edges.scanCol(c1 + offset, c0 + dir*i, dir, j - i + 1);
+        if (found >= 0) {
+            int step = i + found;
+            if (horizontal) hit = Point(c0 + dir*step, c1 + offset);
+            else hit = Point(c1 + offset, c0 + dir*step);
+            return step;
         }
-        if ((canny[0].at<uchar>(liNeg.pos()) > 0) ||
-            (canny[1].at<uchar>(liNeg.pos()) > 0) ||
-            (canny[2].at<uchar>(liNeg.pos()) > 0)) return liNeg.pos();
+        err -= 2*dy*(j - i);
+        i = j;
     }
-    return Point(-1,-1);
+    return -1;
+}
+
+static float sampleMagnitude(const Mat & magnitude, Point2f p) {
+    // Bilinear interpolation of a CV_16SC1 image, clamped at its border
+    float x = min(max(p.x, 0.f), (float)magnitude.cols - 1.001f);
+    float y = min(max(p.y, 0.f), (float)magnitude.rows - 1.001f);
+    int x0 = (int)x, y0 = (int)y;
+    float fx = x - x0, fy = y - y0;
+    const short * r0 = magnitude.ptr<short>(y0) + x0;
+    const short * r1 = magnitude.ptr<short>(y0 + 1) + x0;
+    return (1-fy) * ((1-fx)*r0[0] + fx*r0[1]) + fy * ((1-fx)*r1[0] + fx*r1[1]);
+}
+
+Point2f Whisker::refineEdgePoint(Point edge, Mat magnitude, int radius) {
+    // Moves an edge hit (e.g. from closestEdgePoint2) to the sub-pixel peak of the
+    // gradient magnitude along the whisker's normal.
+    // The hit on a dilated edge map can be a pixel short of the real edge, so the
+    // peak is looked for within radius pixels either side, then a parabola is fitted
+    // through it and its two neighbours.
+    // magnitude: L1 gradient magnitude, CV_16SC1 (see preprocess::edgeMap)
+    Point2f p0 = Point2f(edge.x, edge.y);
+    float samples[16];
+    radius = min(max(radius, 0), 6);
+    int n = 2*radius + 3;
+    for (int i = 0; i < n; i++) samples[i] = sampleMagnitude(magnitude, p0 + (i - radius - 1) * normal);
+    
+    // The strongest sample, excluding the two outermost (needed for the fit)
+    int best = 1;
+    for (int i = 2; i < n - 1; i++) {
+        if (samples[i] > samples[best]) best = i;
+    }
+    
+    float a = samples[best-1], b = samples[best], c = samples[best+1];
+    float curvature = a - 2*b + c;
+    float offset = 0;
+    if (curvature < 0) offset = 0.5f * (a - c) / curvature;
+    offset = min(max(offset, -0.5f), 0.5f);
+    
+    return p0 + (best - radius - 1 + offset) * normal;
+}
+
+vector<EdgeCandidate> Whisker::edgeCandidates(Mat canny, Mat magnitude, int k, int maxDist) {
+    // Finds up to k edges crossing the whisker, best first, rather than only the closest.
+    // Each edge is where the whisker enters a run of edge pixels, on either side.
+    // The prior favours edges that are close to the centre and (if a magnitude image is
+    // given) strong; the solver decides between them (see lsq::poseEstimateSoft).
+    // canny: (dilated) edge map
+    // magnitude: L1 gradient magnitude (CV_16SC1) for refinement and scoring, or empty
+    vector<EdgeCandidate> candidates;
+    if (centre.x < 0 || centre.y < 0 || centre.x >= canny.cols || centre.y >= canny.rows) return candidates;
+    
+    vector<pair<Point, int>> hits;      // Edge point and its distance along the whisker
+    if (canny.at<uchar>(centre) > 0) hits.push_back(make_pair(centre, 0));
+    for (int side = -1; side <= 1; side += 2) {
+        Point end = centre + side * Point(maxDist*normal.x, maxDist*normal.y);
+        LineIterator li(canny, centre, end);
+        bool inEdge = canny.at<uchar>(centre) > 0;
+        int found = 0;
+        ++li;
+        for (int i = 1; i < li.count && found < k; i++, ++li) {
+            bool isEdge = canny.at<uchar>(li.pos()) > 0;
+            if (isEdge && !inEdge) {
+                hits.push_back(make_pair(li.pos(), i));
+                found++;
+            }
+            inEdge = isEdge;
+        }
+    }
+    
+    // Score every hit, then keep the best k
+    float maxMagnitude = 1;
+    vector<float> strength(hits.size(), 1);
+    for (int i = 0; i < hits.size(); i++) {
+        Point2f p = Point2f(hits[i].first.x, hits[i].first.y);
+        if (!magnitude.empty()) {
+            p = refineEdgePoint(hits[i].first, magnitude);
+            strength[i] = sampleMagnitude(magnitude, p);
+            maxMagnitude = max(maxMagnitude, strength[i]);
+        }
+        float d = hits[i].second;
+        candidates.push_back(EdgeCandidate(p, exp(-d*d / (2*CANDIDATE_SIGMA*CANDIDATE_SIGMA))));
+    }
+    for (int i = 0; i < candidates.size(); i++) candidates[i].score *= strength[i] / maxMagnitude;
+    
+    sort(candidates.begin(), candidates.end(), [](const EdgeCandidate & a, const EdgeCandidate & b) {return a.score > b.score;});
+    if (candidates.size() > k) candidates.resize(k);
+    return candidates;
 }
 
 
@@ -112,7 +257,10 @@ double ASM::getArea(InputArray img) {
     return mm.m00;
 }
 
-vector<Whisker> ASM::projectToWhiskers(Model * model, Vec6f pose, Mat K) {
+vector<Whisker> ASM::projectToWhiskers(const Model * model, Vec6f pose, Mat K, double whiskerSpacing, const Distortion * dist) {
+    // whiskerSpacing: distance between whiskers along the projected edges (px), or along
+    //                 the model's edges for planar models (model units)
+    // dist: lens distortion, if any; only the whisker centres and directions are distorted
     
     vector<Whisker> whiskers = {};
     
@@ -142,7 +290,7 @@ vector<Whisker> ASM::projectToWhiskers(Model * model, Vec6f pose, Mat K) {
         }
         
         // Divide up the edge
-        int numWhiskers = MAX(1, ceil(projLength/WHISKER_SPACING));
+        int numWhiskers = MAX(1, ceil(projLength/whiskerSpacing));
         double spacing = length/(numWhiskers+1);
         
         Mat centres;
@@ -153,7 +301,7 @@ vector<Whisker> ASM::projectToWhiskers(Model * model, Vec6f pose, Mat K) {
             hconcat(centres, centrePt, centres);
         }
         
-        // Find the projections of the whisker centres
+        // Find the projections of the whisker centres (without distortion)
         Mat proj = lsq::projection(pose, centres, K);
         
         // Calculate the length and normal of the edge
@@ -163,9 +311,18 @@ vector<Whisker> ASM::projectToWhiskers(Model * model, Vec6f pose, Mat K) {
         normal /= length;
         
         for (int w = 0; w < numWhiskers; w++) {
-            Point centre = Point(proj.col(2+w).at<float>(0), proj.col(2+w).at<float>(1));
+            Point2f c = Point2f(proj.col(2+w).at<float>(0), proj.col(2+w).at<float>(1));
+            Point2f n = normal;
+            if (dist != NULL) {
+                // Move the centre through the lens, and turn the edge with the local
+                // Jacobian of the distortion (looked up) to find its new normal
+                Vec2f tangent = dist->pixelJacobian(c) * Vec2f(-normal.y, normal.x);
+                c = dist->distortPixel(c);
+                n = Point2f(tangent[1], -tangent[0]) * (1 / norm(tangent));
+            }
+            Point centre = Point(c.x, c.y);
             Mat modelCentre = centres.col(2+w);
-            whiskers.push_back(Whisker(centre, normal, modelCentre));
+            whiskers.push_back(Whisker(centre, n, modelCentre));
         }
     }
     
@@ -14,12 +14,22 @@
 #include <opencv2/imgproc/imgproc.hpp>
 #include <iostream>
 #include <stdio.h>
+#include "bitedges.hpp"
+#include "distortion.hpp"
 #include "models.hpp"
 
 using namespace std;
 using namespace cv;
 
 
+class EdgeCandidate {
+public:
+    EdgeCandidate(Point2f p_in, float s_in) : point(p_in), score(s_in) {}
+    Point2f point;
+    float score;    // Prior weight (0-1) of this being the whisker's edge
+};
+
+
 class Whisker {
 public:
     Whisker(Point c_in, Point2f n_in, Mat mp_in) : centre(c_in), normal(n_in), modelCentre(mp_in) {}
@@ -28,10 +38,17 @@ public:
     Mat modelCentre;
     Point closestEdgePoint(Mat edges, int maxDist = MAX_DIST);
     Point closestEdgePoint2(Mat canny, int maxDist = MAX_DIST);
-    Point closestEdgePoint2(Mat canny[3], int maxDist = MAX_DIST);
+    Point closestEdgePoint2(const BitEdgeMap & edges, int maxDist = MAX_DIST);
+    Point2f refineEdgePoint(Point edge, Mat magnitude, int radius = REFINE_RADIUS);
+    vector<EdgeCandidate> edgeCandidates(Mat canny, Mat magnitude, int k, int maxDist = MAX_DIST);
+    bool searchesRows(int maxDist = MAX_DIST) const;
+private:
+    int firstEdge(const BitEdgeMap & edges, Point end, int steps, Point & hit);
 private:
     static const int MAX_DIST = 45;
     static constexpr double CROSS_EPS = 1;
+    static const int REFINE_RADIUS = 2;     // Pixels either side of a hit to look for the gradient peak
+    static constexpr float CANDIDATE_SIGMA = 15;    // Distance (px) over which a candidate's prior falls off
 };
 
 
@@ -39,8 +56,8 @@ class ASM {
 public:
     static Point getCentroid(InputArray img);
     static double getArea(InputArray img);
-    static vector<Whisker> projectToWhiskers(Model * model, Vec6f pose, Mat K);
-private:
+    static vector<Whisker> projectToWhiskers(const Model * model, Vec6f pose, Mat K, double spacing = WHISKER_SPACING, const Distortion * dist = NULL);
+public:
     static constexpr double WHISKER_SPACING = 20;
 };
 
@@ -0,0 +1,161 @@
+//
+//  bitedges.cpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#include <algorithm>
+#include <string.h>
+
+#include "bitedges.hpp"
+
+
+static void transpose64(uint64_t a[64]) {
+    // Transposes a 64 x 64 bit matrix in place: bit j of a[i] swaps with bit i of a[j].
+    // Swaps ever smaller blocks: 32 x 32, then 16 x 16, ... down to single bits.
+    uint64_t m = 0x00000000FFFFFFFFULL;
+    for (int j = 32; j != 0; j >>= 1, m ^= m << j) {
+        for (int k = 0; k < 64; k = ((k | j) + 1) & ~j) {
+            uint64_t t = ((a[k] >> j) ^ a[k | j]) & m;
+            a[k] ^= t << j;
+            a[k | j] ^= t;
+        }
+    }
+}
+
+void BitEdgeMap::setEdges(Mat edges_in) {
+    // Starts a new frame: no copy is packed until one is required
+    CV_Assert(edges_in.type() == CV_8UC1);
+    edges = edges_in;
+    width = edges.cols;
+    height = edges.rows;
+    rowWords = (width + 63) / 64;
+    colWords = (height + 63) / 64;
+    hasRows = false;
+    hasCols = false;
+}
+
+void BitEdgeMap::require(bool rowMajor, bool colMajor) {
+    // Packs whichever of the copies are asked for and not yet packed.
+    // Not thread-safe: call it before searching in parallel.
+    if (rowMajor && !hasRows) {
+        packRows(rows);
+        hasRows = true;
+    }
+    if (colMajor && !hasCols) {
+        if (!hasRows) packRows(scratch);
+        packCols();
+        hasCols = true;
+    }
+}
+
+void BitEdgeMap::packRows(vector<uint64_t> & words) const {
+    // Packs the byte map row by row, 8 pixels per step: each byte is folded onto its
+    // lowest bit (set if any bit was), then one multiply gathers the 8 lowest bits into
+    // the top byte. (Pixel x + i is byte i of the load: little-endian.)
+    words.assign(rowWords * height, 0);
+    for (int y = 0; y < height; y++) {
+        const uchar * p = edges.ptr<uchar>(y);
+        uint64_t * r = words.data() + y*rowWords;
+        int x = 0;
+        for (; x + 8 <= width; x += 8) {
+            uint64_t v;
+            memcpy(&v, p + x, 8);
+            v |= v >> 4;
+            v |= v >> 2;
+            v |= v >> 1;
+            v &= 0x0101010101010101ULL;
+            r[x >> 6] |= ((v * 0x0102040810204080ULL) >> 56) << (x & 63);
+        }
+        for (; x < width; x++) {
+            if (p[x] != 0) r[x >> 6] |= 1ULL << (x & 63);
+        }
+    }
+}
+
+void BitEdgeMap::packCols() {
+    // Transposes the row-major bits, a 64 x 64 block at a time
+    const vector<uint64_t> & r = hasRows ? rows : scratch;
+    cols.assign(colWords * width, 0);
+    uint64_t block[64];
+    for (int by = 0; by < colWords; by++) {
+        for (int bx = 0; bx < rowWords; bx++) {
+            for (int i = 0; i < 64; i++) {
+                int y = by*64 + i;
+                block[i] = y < height ? r[y*rowWords + bx] : 0;
+            }
+            transpose64(block);
+            for (int j = 0; j < 64 && bx*64 + j < width; j++) cols[(bx*64 + j)*colWords + by] = block[j];
+        }
+    }
+}
+
+bool BitEdgeMap::test(int x, int y) const {
+    if (x < 0 || y < 0 || x >= width || y >= height) return false;
+    if (hasRows) return (rows[y*rowWords + (x >> 6)] >> (x & 63)) & 1;
+    if (hasCols) return (cols[x*colWords + (y >> 6)] >> (y & 63)) & 1;
+    return edges.at<uchar>(y, x) != 0;
+}
+
+int BitEdgeMap::scanRow(int y, int x, int dir, int length) const {
+    // Looks along row y from x, in direction dir (+1 or -1), for at most length pixels.
+    // Returns how many pixels along the first edge is (0 = at x), or -1 if there is none.
+    // Without the row-major copy, the pixels are tested one at a time.
+    if (y < 0 || y >= height || x < 0 || x >= width) return -1;
+    length = dir > 0 ? min(length, width - x) : min(length, x + 1);
+    if (!hasRows) {
+        for (int i = 0; i < length; i++) {
+            if (test(x + dir*i, y)) return i;
+        }
+        return -1;
+    }
+    return scan(rows.data() + y*rowWords, x, dir, length);
+}
+
+int BitEdgeMap::scanCol(int x, int y, int dir, int length) const {
+    // As scanRow, down (dir = +1) or up (dir = -1) column x from y
+    if (y < 0 || y >= height || x < 0 || x >= width) return -1;
+    length = dir > 0 ? min(length, height - y) : min(length, y + 1);
+    if (!hasCols) {
+        for (int i = 0; i < length; i++) {
+            if (test(x, y + dir*i)) return i;
+        }
+        return -1;
+    }
+    return scan(cols.data() + x*colWords, y, dir, length);
+}
+
+int BitEdgeMap::scan(const uint64_t * words, int start, int dir, int length) {
+    // Finds the first set bit from bit 'start' in direction dir, within length bits.
+    // Forwards uses the lowest set bit of each word (count trailing zeros),
+    // backwards the highest (count leading zeros).
+    if (length <= 0) return -1;
+    if (dir > 0) {
+        int last = start + length - 1;
+        int w = start >> 6;
+        uint64_t bits = words[w] & (~0ULL << (start & 63));
+        while (true) {
+            if (bits != 0) {
+                int pos = (w << 6) + __builtin_ctzll(bits);
+                return pos <= last ? pos - start : -1;
+            }
+            if (++w > (last >> 6)) return -1;
+            bits = words[w];
+        }
+    }
+    else {
+        int last = start - length + 1;
+        int w = start >> 6;
+        uint64_t bits = words[w] & (~0ULL >> (63 - (start & 63)));
+        while (true) {
+            if (bits != 0) {
+                int pos = (w << 6) + 63 - __builtin_clzll(bits);
+                return pos >= last ? start - pos : -1;
+            }
+            if (--w < (last >> 6)) return -1;
+            bits = words[w];
+        }
+    }
+}
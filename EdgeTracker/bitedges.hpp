@@ -0,0 +1,64 @@
+//
+//  bitedges.hpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#ifndef bitedges_hpp
+#define bitedges_hpp
+
+#include <opencv2/core/core.hpp>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include <stdio.h>
+
+using namespace std;
+using namespace cv;
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+//      An edge map with 1 bit per pixel, packed row-major and/or
+//      column-major, so that a search along a row or a column tests
+//      64 pixels at a time and finds the first edge with one bit scan.
+//      Each copy is only packed once something asks for it (require),
+//      so a frame whose whiskers are all near-horizontal never packs
+//      the column-major copy. The byte map it is packed from is still
+//      needed (it is the preprocessing's output), so the bits shrink
+//      the search's working set rather than the frame's memory.
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+class BitEdgeMap {
+    
+/*
+ METHODS
+ */
+public:
+    void setEdges(Mat edges_in);
+    void require(bool rowMajor, bool colMajor);
+    void build(Mat edges_in) {setEdges(edges_in); require(true, true);}
+    bool test(int x, int y) const;
+    int scanRow(int y, int x, int dir, int length) const;
+    int scanCol(int x, int y, int dir, int length) const;
+    int getWidth() const {return width;}
+    int getHeight() const {return height;}
+    
+private:
+    void packRows(vector<uint64_t> & words) const;
+    void packCols();
+    static int scan(const uint64_t * words, int start, int dir, int length);
+    
+private:
+    Mat edges;                  // The byte map being packed (CV_8UC1, non-zero is an edge)
+    int width = 0, height = 0;
+    int rowWords = 0;           // Words per row of the row-major copy
+    int colWords = 0;           // Words per column of the column-major copy
+    bool hasRows = false, hasCols = false;  // Which copies are packed for the current edges
+    vector<uint64_t> rows;      // Bit x of row y is bit (x % 64) of rows[y*rowWords + x/64]
+    vector<uint64_t> cols;      // Bit y of column x is bit (y % 64) of cols[x*colWords + y/64]
+    vector<uint64_t> scratch;   // Rows packed only on the way to the column-major copy
+    
+};
+
+#endif /* bitedges_hpp */
@@ -0,0 +1,120 @@
+//
+//  budget.cpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#include <algorithm>
+
+#include "budget.hpp"
+
+
+// From the most to the least thorough:
+//  whisker spacing, max projections per model, solver steps per projection, pyramid level
+const BudgetLevel FrameBudget::LEVELS[FrameBudget::NUM_LEVELS] = {
+    {20, 20, 2, 0},
+    {30, 10, 2, 0},
+    {40,  6, 2, 0},
+    {40,  4, 1, 0},
+    {40,  4, 1, 1},
+    {60,  2, 1, 1}
+};
+
+
+void FrameBudget::apply(Tracker & tracker, chrono::steady_clock::time_point frameStart) {
+    // Sets the tracker up for the next frame, which started at frameStart
+    const BudgetLevel & l = LEVELS[level];
+    tracker.whiskerSpacing = l.whiskerSpacing;
+    tracker.maxIterations = l.maxIterations;
+    tracker.solverIterations = l.solverIterations;
+    tracker.pyramidLevel = l.pyramidLevel;
+    tracker.deadline = frameStart + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double, milli>(targetTime * DEADLINE));
+    numModels = (int)tracker.getModels().size();
+}
+
+bool FrameBudget::allowErrors() const {
+    // Whether the area error pass is predicted to fit in this frame too
+    if (!measured) return true;
+    return predict(level) + errorCost <= HEADROOM * targetTime;
+}
+
+double FrameBudget::predict(int l) const {
+    // The expected frame time (ms) at level l, from the measured costs
+    if (!measured) return 0;
+    const BudgetLevel & b = LEVELS[l];
+    double scale = 1 << b.pyramidLevel;
+    
+    // Edge detection goes with the no. of pixels, the no. of whiskers with the edge
+    // length over the spacing (projected for 3D models, on the model for planar ones)
+    double preprocess = preprocessCost / (scale * scale);
+    double perIteration = planarShare * planarWhiskersPerIteration + (1 - planarShare) * solidWhiskersPerIteration / scale;
+    double whiskers = perIteration * (ASM::WHISKER_SPACING / b.whiskerSpacing);
+    double iterations = min(iterationsNeeded, (double)b.maxIterations * max(numModels, 1));
+    return preprocess + whiskerCost * whiskers * iterations + otherCost;
+}
+
+void FrameBudget::record(const FrameStats & stats, double frameTime, double errorTime) {
+    // Updates the costs from a finished frame, and picks the level for the next one.
+    // frameTime: the whole frame, including the error pass (ms)
+    // errorTime: the area error pass, 0 if it was skipped (ms)
+    frames++;
+    framesAtLevel[level]++;
+    if (frameTime > targetTime) misses++;
+    worst = max(worst, frameTime);
+    skippedModels += stats.skipped;
+    if (errorTime > 0) errorPasses++;
+    
+    const BudgetLevel & b = LEVELS[level];
+    double scale = 1 << b.pyramidLevel;
+    auto update = [&](double & average, double value) {
+        average = measured ? (1 - SMOOTHING) * average + SMOOTHING * value : value;
+    };
+    
+    update(preprocessCost, stats.preprocessTime * scale * scale);
+    if (stats.whiskers > 0) update(whiskerCost, stats.trackTime / stats.whiskers);
+    double spacing = b.whiskerSpacing / ASM::WHISKER_SPACING;
+    int solidIterations = stats.iterations - stats.planarIterations;
+    if (stats.iterations > 0) update(planarShare, (double)stats.planarIterations / stats.iterations);
+    if (stats.planarIterations > 0) {
+        double value = (double)stats.planarWhiskers / stats.planarIterations * spacing;
+        planarWhiskersPerIteration = planarWhiskersPerIteration > 0 ? (1 - SMOOTHING) * planarWhiskersPerIteration + SMOOTHING * value : value;
+    }
+    if (solidIterations > 0) {
+        double value = (double)(stats.whiskers - stats.planarWhiskers) / solidIterations * spacing * scale;
+        solidWhiskersPerIteration = solidWhiskersPerIteration > 0 ? (1 - SMOOTHING) * solidWhiskersPerIteration + SMOOTHING * value : value;
+    }
+    
+    // When capped, the iterations only show a lower bound of what is needed
+    bool capped = stats.skipped > 0 || stats.iterations >= b.maxIterations * max(numModels, 1);
+    if (!capped) update(iterationsNeeded, stats.iterations);
+    else iterationsNeeded = max(iterationsNeeded, (double)stats.iterations);
+    
+    update(otherCost, max(0.0, frameTime - stats.preprocessTime - stats.trackTime - errorTime));
+    if (errorTime > 0) {
+        if (errorCost == 0) errorCost = errorTime;
+        else errorCost = (1 - SMOOTHING) * errorCost + SMOOTHING * errorTime;
+    }
+    measured = true;
+    
+    // Back off until the prediction fits, and only go back up with room to spare
+    int l = level;
+    if (frameTime > targetTime) l = min(l + 1, NUM_LEVELS - 1);
+    while (l < NUM_LEVELS - 1 && predict(l) > HEADROOM * targetTime) l++;
+    while (l > 0 && l <= level && predict(l - 1) < UPGRADE_HEADROOM * targetTime) l--;
+    level = l;
+}
+
+void FrameBudget::report() const {
+    printf("Frame budget = %.1f ms\n", targetTime);
+    printf("Frames       = %lli\n", frames);
+    printf("Misses       = %lli (%.1f%%)\n", misses, frames > 0 ? 100.0 * misses / frames : 0.0);
+    printf("Worst        = %.1f ms\n", worst);
+    printf("Models skipped = %lli, error passes = %lli\n", skippedModels, errorPasses);
+    printf("Level  Spacing  Iter  Solver  Pyramid  Frames\n");
+    for (int l = 0; l < NUM_LEVELS; l++) {
+        const BudgetLevel & b = LEVELS[l];
+        printf("%5i  %7.0f  %4i  %6i  %7i  %6lli\n", l, b.whiskerSpacing, b.maxIterations, b.solverIterations, b.pyramidLevel, framesAtLevel[l]);
+    }
+}
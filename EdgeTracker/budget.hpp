@@ -0,0 +1,92 @@
+//
+//  budget.hpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#ifndef budget_hpp
+#define budget_hpp
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include <stdio.h>
+
+#include "tracker.hpp"
+
+using namespace std;
+
+
+// * * * * * * * * * * * * * * *
+//      BudgetLevel
+// * * * * * * * * * * * * * * *
+
+class BudgetLevel {
+public:
+    double whiskerSpacing;      // px, at full resolution
+    int maxIterations;          // Whisker projections per model
+    int solverIterations;       // Solver steps per projection
+    int pyramidLevel;           // Track at 1/2^level resolution
+};
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+//      Keeps each frame within a target time. Before each frame it
+//      picks the most thorough level of tracking that the measured
+//      stage costs predict will fit, and sets a deadline after which
+//      the tracker stops refining. The area error pass only runs if
+//      there is time to spare. Frames that still overrun are counted.
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+class FrameBudget {
+    
+/*
+ METHODS
+ */
+public:
+    FrameBudget(double targetTime_in) : targetTime(targetTime_in), framesAtLevel(NUM_LEVELS) {}
+    void apply(Tracker & tracker, chrono::steady_clock::time_point frameStart);
+    bool allowErrors() const;
+    void record(const FrameStats & stats, double frameTime, double errorTime = 0);
+    void report() const;
+    int getLevel() const {return level;}
+    long long getMisses() const {return misses;}
+    
+private:
+    double predict(int l) const;
+    
+private:
+    double targetTime;              // ms
+    int level = 0;                  // Index into LEVELS; 0 is the most thorough
+    bool measured = false;          // Whether there are any costs yet
+    int numModels = 1;
+    
+    // Measured costs (moving averages), normalised to level 0 where they depend on it
+    double preprocessCost = 0;      // Edge detection at full resolution (ms)
+    double whiskerCost = 0;         // Search and solve, per whisker (ms)
+    double solidWhiskersPerIteration = 0;   // Of 3D models, at full resolution and the default spacing
+    double planarWhiskersPerIteration = 0;  // Of planar models (at any resolution), at the default spacing
+    double planarShare = 0;         // The fraction of whisker projections that are of planar models
+    double iterationsNeeded = 0;    // Whisker projections per frame, over all models, when not capped
+    double otherCost = 0;           // Everything else in the frame (ms)
+    double errorCost = 0;           // The area error pass (ms)
+    
+    long long frames = 0, misses = 0, skippedModels = 0, errorPasses = 0;
+    double worst = 0;
+    vector<long long> framesAtLevel;
+    
+/*
+ CONSTANTS
+ */
+public:
+    static const int NUM_LEVELS = 6;
+    static const BudgetLevel LEVELS[NUM_LEVELS];
+    static constexpr double HEADROOM = 0.85;        // Plan to use at most this fraction of the target
+    static constexpr double UPGRADE_HEADROOM = 0.7; // ...and only go more thorough below this fraction
+    static constexpr double DEADLINE = 0.9;         // Stop refining at this fraction of the target
+    static constexpr double SMOOTHING = 0.1;        // Weight of the newest frame in the moving averages
+    
+};
+
+#endif /* budget_hpp */
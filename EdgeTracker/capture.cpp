@@ -0,0 +1,94 @@
+//
+//  capture.cpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#include "capture.hpp"
+
+
+// * * * * * * * * * * * * * * *
+//      LiveSource
+// * * * * * * * * * * * * * * *
+
+LiveSource::LiveSource(FrameSource * source_in) : source(source_in) {
+    captureThread = thread(&LiveSource::capture, this);
+}
+
+LiveSource::~LiveSource() {
+    // Waits for the source's current read to finish
+    stopping = true;
+    if (captureThread.joinable()) captureThread.join();
+}
+
+void LiveSource::capture() {
+    Size size;
+    int type = CV_8UC3;
+    long long number = 0;
+    while (!stopping) {
+        // Read into a buffer nobody still holds (sources that bring their own replace it)
+        Slot & slot = slots[back];
+        slot.frame = Mat();
+        if (size.area() > 0) slot.frame = pool.acquire(size, type);
+        if (!source->read(slot.frame)) break;
+        slot.time = chrono::steady_clock::now();
+        slot.number = number++;
+        size = slot.frame.size();
+        type = slot.frame.type();
+        
+        // Publish it, taking back whichever slot was the latest (read or not)
+        back = latest.exchange(back | FRESH) & ~FRESH;
+        {lock_guard<mutex> guard(wakeLock);}
+        wake.notify_one();
+    }
+    
+    finished = true;
+    {lock_guard<mutex> guard(wakeLock);}
+    wake.notify_one();
+}
+
+bool LiveSource::read(Mat & frame) {
+    // Waits for a frame newer than the last one read, then takes the newest
+    {
+        unique_lock<mutex> guard(wakeLock);
+        wake.wait(guard, [this] {return (latest & FRESH) || finished;});
+    }
+    if (!(latest & FRESH)) {
+        frame = Mat();
+        return false;
+    }
+    
+    // Only this thread clears FRESH, so the slot taken is always unread
+    front = latest.exchange(front) & ~FRESH;
+    Slot & slot = slots[front];
+    frame = slot.frame;
+    captureTime = slot.time;
+    dropped += slot.number - lastNumber - 1;
+    lastNumber = slot.number;
+    return true;
+}
+
+
+// * * * * * * * * * * * * * * *
+//      PacedSource
+// * * * * * * * * * * * * * * *
+
+PacedSource::PacedSource(FrameSource * source_in, double fps) : source(source_in) {
+    period = chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(1.0 / fps));
+}
+
+bool PacedSource::read(Mat & frame) {
+    // The frame is 'captured' at its time in the schedule, or when it is read if
+    // the source is too slow to keep to it (the schedule then restarts from there)
+    auto now = chrono::steady_clock::now();
+    if (!started || next < now) next = now;
+    else this_thread::sleep_until(next);
+    started = true;
+    
+    if (!source->read(frame)) return false;
+    captureTime = chrono::steady_clock::now();
+    next += period;
+    return true;
+}
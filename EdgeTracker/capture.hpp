@@ -0,0 +1,106 @@
+//
+//  capture.hpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#ifndef capture_hpp
+#define capture_hpp
+
+#include <opencv2/core/core.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <stdio.h>
+
+#include "framecontext.hpp"
+#include "sources.hpp"
+
+using namespace std;
+using namespace cv;
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+//      Reads another source on its own thread, as fast as it delivers,
+//      and keeps only the newest frame. Each read returns the newest
+//      frame not yet returned, so the tracker never works through a
+//      backlog: if it falls behind, the frames in between are dropped.
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+class LiveSource : public FrameSource {
+    
+/*
+ METHODS
+ */
+public:
+    LiveSource(FrameSource * source_in);
+    ~LiveSource();
+    bool read(Mat & frame);
+    chrono::steady_clock::time_point getCaptureTime() const {return captureTime;}
+    long long getDropped() const {return dropped;}
+    
+private:
+    void capture();
+    
+private:
+    class Slot {
+    public:
+        Mat frame;
+        chrono::steady_clock::time_point time;  // When the frame was captured
+        long long number = 0;                   // Its place in the source
+    };
+    
+    unique_ptr<FrameSource> source;
+    thread captureThread;
+    
+    // Three slots change hands without locking: the capture thread fills 'back',
+    // the reader holds 'front', and 'latest' is the newest frame (FRESH if unread)
+    Slot slots[3];
+    atomic<int> latest {0};
+    int back = 1;                   // Capture thread only
+    int front = 2;                  // Reader only
+    BufferPool pool;                // Capture thread only
+    
+    mutex wakeLock;                 // Only for sleeping until there is a new frame
+    condition_variable wake;
+    atomic<bool> finished {false};
+    atomic<bool> stopping {false};
+    
+    chrono::steady_clock::time_point captureTime;
+    long long lastNumber = -1;
+    long long dropped = 0;
+    
+/*
+ CONSTANTS
+ */
+private:
+    static const int FRESH = 4;     // Set in 'latest' while its frame is unread
+    
+};
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+//      Delivers the frames of another source at a fixed rate, like a
+//      camera. On its own, reads wait for the next frame time; behind
+//      a LiveSource, frames are dropped when tracking can't keep up.
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+class PacedSource : public FrameSource {
+public:
+    PacedSource(FrameSource * source_in, double fps);
+    bool read(Mat & frame);
+    chrono::steady_clock::time_point getCaptureTime() const {return captureTime;}
+    
+private:
+    unique_ptr<FrameSource> source;
+    chrono::steady_clock::duration period;
+    chrono::steady_clock::time_point next;
+    chrono::steady_clock::time_point captureTime;
+    bool started = false;
+};
+
+#endif /* capture_hpp */
@@ -0,0 +1,118 @@
+//
+//  display.cpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#include "display.hpp"
+#include "profiler.hpp"
+
+
+// * * * * * * * * * * * * * * *
+//      Producer side
+// * * * * * * * * * * * * * * *
+
+bool Display::openVideo(string path, Size size, double fps) {
+    // Also writes every rendered frame (not the dropped ones) to an annotated video
+    video.open(path, VideoWriter::fourcc('M','J','P','G'), fps, size);
+    writingVideo = video.isOpened();
+    return writingVideo;
+}
+
+void Display::submit(Snapshot snapshot) {
+    // Hands the display a new snapshot, replacing any it has not got to yet.
+    // Never waits for rendering.
+    if (!active()) return;
+    {
+        lock_guard<mutex> guard(lock);
+        if (hasLatest) dropped++;
+        latest = snapshot;
+        hasLatest = true;
+    }
+    updated.notify_one();
+}
+
+void Display::show(string window, Mat img) {
+    // Shows an extra image in its own window (ignored when there are no windows).
+    // The image is only referenced, so it must not be written to afterwards.
+    if (!showWindows) return;
+    {
+        lock_guard<mutex> guard(lock);
+        images[window] = img;
+    }
+    updated.notify_one();
+}
+
+void Display::finish() {
+    // Lets run() return once it has drawn the last snapshot
+    {
+        lock_guard<mutex> guard(lock);
+        done = true;
+    }
+    updated.notify_one();
+}
+
+
+// * * * * * * * * * * * * * * *
+//      Display thread
+// * * * * * * * * * * * * * * *
+
+void Display::run() {
+    // The display loop. On macOS the windows must belong to the main thread,
+    // so call this from main and do the tracking on another thread.
+    Mat img;
+    while (true) {
+        Snapshot snapshot;
+        map<string, Mat> extra;
+        bool haveSnapshot, finished;
+        {
+            unique_lock<mutex> guard(lock);
+            // Wake up regularly anyway to keep the windows responsive
+            updated.wait_for(guard, chrono::milliseconds(30), [this] {return hasLatest || !images.empty() || done;});
+            haveSnapshot = hasLatest;
+            if (hasLatest) snapshot = latest;
+            hasLatest = false;
+            extra.swap(images);
+            finished = done;
+        }
+        
+        if (haveSnapshot) {
+            render(snapshot, img);
+            if (showWindows) imshow("Frame", img);
+            if (video.isOpened()) video << img;
+        }
+        for (auto & e : extra) imshow(e.first, e.second);
+        
+        if (showWindows) {
+            int key = waitKey(1);
+            if (key == 'q') quit = true;
+            else if (key == 'p') pause = !pause;
+        }
+        
+        if (finished && !haveSnapshot) break;
+    }
+    video.release();
+}
+
+void Display::render(Snapshot & snapshot, Mat & img) {
+    PROFILE_SCOPE(STAGE_DRAW);
+    snapshot.frame.copyTo(img);
+    
+    // Whiskers, then the models over the top
+    for (int w = 0; w < snapshot.whiskers.size(); w++) {
+        Point centre = Point(snapshot.whiskers[w][0], snapshot.whiskers[w][1]);
+        Point edge = Point(snapshot.whiskers[w][2], snapshot.whiskers[w][3]);
+        line(img, edge, centre, Scalar(255,150,0), 2);
+        circle(img, edge, 3, Scalar(0,255,0), -1);
+        circle(img, centre, 3, Scalar(0,0,255), -1);
+    }
+    for (int m = 0; m < models.size() && m < snapshot.est.size(); m++) {
+        models[m]->draw(img, snapshot.est[m].pose, K, true);
+    }
+    
+    char text[64];
+    snprintf(text, sizeof(text), "%i   %.1f ms", snapshot.frameNo, snapshot.time);
+    putText(img, text, Point(10, 25), FONT_HERSHEY_SIMPLEX, 0.7, Scalar(0,255,255), 2);
+}
@@ -0,0 +1,90 @@
+//
+//  display.hpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#ifndef display_hpp
+#define display_hpp
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/videoio/videoio.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <stdio.h>
+
+#include "lsq.hpp"
+#include "models.hpp"
+
+using namespace std;
+using namespace cv;
+
+
+// * * * * * * * * * * * * * * *
+//      Snapshot
+// * * * * * * * * * * * * * * *
+
+class Snapshot {
+public:
+    int frameNo = 0;
+    Mat frame;                  // Not drawn on: the tracker may still be reading it
+    vector<estimate> est;
+    vector<Vec4i> whiskers;     // (centre x, y, edge x, y) of each matched whisker
+    double time = 0;            // Processing time of the frame (ms)
+};
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+//      Draws the tracking results on its own thread, at its own rate.
+//      Only the latest snapshot is kept: if the display falls behind,
+//      older ones are dropped, so tracking never waits for it.
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+class Display {
+    
+/*
+ METHODS
+ */
+public:
+    Display(vector<const Model *> models_in, Mat K_in, bool showWindows_in = true) : models(models_in), K(K_in), showWindows(showWindows_in) {}
+    bool openVideo(string path, Size size, double fps = 30);
+    bool active() const {return showWindows || writingVideo;}
+    void submit(Snapshot snapshot);
+    void show(string window, Mat img);
+    void run();
+    void finish();
+    bool quitRequested() const {return quit;}
+    bool paused() const {return pause;}
+    long long getDropped() const {return dropped;}
+    
+private:
+    void render(Snapshot & snapshot, Mat & img);
+    
+private:
+    vector<const Model *> models;
+    Mat K;
+    bool showWindows;
+    bool writingVideo = false;
+    VideoWriter video;
+    
+    mutex lock;
+    condition_variable updated;
+    Snapshot latest;
+    bool hasLatest = false;
+    map<string, Mat> images;        // Extra (debugging) images, latest per window
+    bool done = false;
+    
+    atomic<bool> quit {false};
+    atomic<bool> pause {false};
+    atomic<long long> dropped {0};
+    
+};
+
+#endif /* display_hpp */
@@ -0,0 +1,83 @@
+//
+//  distortion.cpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#include <algorithm>
+
+#include "distortion.hpp"
+
+
+Distortion::Distortion(Mat K_in, Mat coefficients, Size size_in) : size(size_in) {
+    // K_in: intrinsic matrix (the pixels of 'size' are in its frame)
+    // coefficients: k1, k2, p1, p2[, k3], as in OpenCV's calibrateCamera
+    // size: image size, over which the Jacobian lookup is built
+    Mat c = Mat_<float>(coefficients.reshape(1, 1));
+    const float * d = c.ptr<float>();
+    if (c.cols > 0) k1 = d[0];
+    if (c.cols > 1) k2 = d[1];
+    if (c.cols > 3) { p1 = d[2]; p2 = d[3]; }
+    if (c.cols > 4) k3 = d[4];
+    K = Mat_<float>(K_in);
+    Kinv = K.inv();
+    
+    // Sample the Jacobian at the grid corners, covering the whole image
+    gridCols = size.width / GRID_CELL + 2;
+    gridRows = size.height / GRID_CELL + 2;
+    grid.resize(gridCols * gridRows);
+    for (int r = 0; r < gridRows; r++) {
+        for (int g = 0; g < gridCols; g++) {
+            grid[r*gridCols + g] = pixelJacobianExact(Point2f(g * GRID_CELL, r * GRID_CELL));
+        }
+    }
+}
+
+Point2f Distortion::distortNormalised(Point2f n) const {
+    // Distorts a point on the normalised image plane (z = 1)
+    float x = n.x, y = n.y;
+    float r2 = x*x + y*y;
+    float radial = 1 + r2*(k1 + r2*(k2 + r2*k3));
+    return Point2f(x*radial + 2*p1*x*y + p2*(r2 + 2*x*x),
+                   y*radial + p1*(r2 + 2*y*y) + 2*p2*x*y);
+}
+
+Matx22f Distortion::jacobianNormalised(Point2f n) const {
+    // The Jacobian of distortNormalised at n
+    float x = n.x, y = n.y;
+    float r2 = x*x + y*y;
+    float radial = 1 + r2*(k1 + r2*(k2 + r2*k3));
+    float dRadial = k1 + r2*(2*k2 + 3*r2*k3);   // d(radial)/d(r2)
+    return Matx22f(radial + 2*x*x*dRadial + 2*p1*y + 6*p2*x,    2*x*y*dRadial + 2*p1*x + 2*p2*y,
+                   2*x*y*dRadial + 2*p1*x + 2*p2*y,             radial + 2*y*y*dRadial + 6*p1*y + 2*p2*x);
+}
+
+Point2f Distortion::distortPixel(Point2f p) const {
+    // Where the undistorted pixel p is seen through the lens
+    Vec3f n = Kinv * Vec3f(p.x, p.y, 1);
+    Point2f d = distortNormalised(Point2f(n[0], n[1]));
+    Vec3f q = K * Vec3f(d.x, d.y, 1);
+    return Point2f(q[0], q[1]);
+}
+
+Matx22f Distortion::pixelJacobian(Point2f p) const {
+    // The Jacobian of distortPixel at p, interpolated from the grid (clamped at its edges)
+    float gx = min(max(p.x / GRID_CELL, 0.f), gridCols - 1.001f);
+    float gy = min(max(p.y / GRID_CELL, 0.f), gridRows - 1.001f);
+    int x0 = (int)gx, y0 = (int)gy;
+    float fx = gx - x0, fy = gy - y0;
+    const Matx22f * r0 = &grid[y0*gridCols + x0];
+    const Matx22f * r1 = r0 + gridCols;
+    return (1-fy) * ((1-fx)*r0[0] + fx*r0[1]) + fy * ((1-fx)*r1[0] + fx*r1[1]);
+}
+
+Matx22f Distortion::pixelJacobianExact(Point2f p) const {
+    // The Jacobian of distortPixel at p: K * jacobianNormalised * K^-1 (the 2x2 parts,
+    // as the last row of K is 0 0 1)
+    Vec3f n = Kinv * Vec3f(p.x, p.y, 1);
+    Matx22f K2 = Matx22f(K(0,0), K(0,1), K(1,0), K(1,1));
+    Matx22f Kinv2 = Matx22f(Kinv(0,0), Kinv(0,1), Kinv(1,0), Kinv(1,1));
+    return K2 * jacobianNormalised(Point2f(n[0], n[1])) * Kinv2;
+}
@@ -0,0 +1,59 @@
+//
+//  distortion.hpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#ifndef distortion_hpp
+#define distortion_hpp
+
+#include <opencv2/core/core.hpp>
+#include <iostream>
+#include <vector>
+#include <stdio.h>
+
+using namespace std;
+using namespace cv;
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+//      Lens distortion (OpenCV's k1, k2, p1, p2[, k3] model), applied
+//      to projected points rather than undoing it for every pixel of
+//      the frame. The local Jacobian of the distortion in pixels is
+//      precomputed on a coarse grid, to turn the whisker directions.
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+class Distortion {
+    
+/*
+ METHODS
+ */
+public:
+    Distortion() {}
+    Distortion(Mat K, Mat coefficients, Size size);
+    Point2f distortNormalised(Point2f n) const;
+    Matx22f jacobianNormalised(Point2f n) const;
+    Point2f distortPixel(Point2f p) const;
+    Matx22f pixelJacobian(Point2f p) const;
+    Size getSize() const {return size;}
+    
+private:
+    Matx22f pixelJacobianExact(Point2f p) const;
+    
+private:
+    float k1 = 0, k2 = 0, p1 = 0, p2 = 0, k3 = 0;
+    Matx33f K, Kinv;
+    Size size;
+    int gridCols = 0, gridRows = 0;
+    vector<Matx22f> grid;       // Pixel Jacobian at every GRID_CELL-th (undistorted) pixel, row-major
+    
+/*
+ CONSTANTS
+ */
+public:
+    static const int GRID_CELL = 16;    // px between the grid points of the Jacobian lookup
+    
+};
+
+#endif /* distortion_hpp */
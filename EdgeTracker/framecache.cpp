@@ -0,0 +1,137 @@
+//
+//  framecache.cpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#include <opencv2/videoio/videoio.hpp>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "framecache.hpp"
+
+static const char MAGIC[8] = "ETFRAME";
+
+
+// * * * * * * * * * * * * * * *
+//      FrameCache
+// * * * * * * * * * * * * * * *
+
+bool FrameCache::build(string videoPath, string cachePath, int maxFrames) {
+    // Decodes every frame of the video (or the first maxFrames, if > 0) into the cache.
+    // Returns false if the video can't be read or the cache can't be written.
+    VideoCapture cap(videoPath);
+    if (!cap.isOpened()) return false;
+    FILE * out = fopen(cachePath.c_str(), "wb");
+    if (out == NULL) return false;
+    
+    FrameCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.fps = cap.get(CV_CAP_PROP_FPS);
+    fwrite(&header, sizeof(header), 1, out);    // Rewritten at the end
+    
+    vector<FrameCacheEntry> index;
+    vector<uint8_t> padding(FRAME_ALIGN, 0);
+    uint64_t pos = sizeof(header);
+    Mat frame;
+    bool ok = true;
+    while ((maxFrames <= 0 || (int)index.size() < maxFrames) && cap.read(frame) && !frame.empty()) {
+        if (index.empty()) {
+            header.width = frame.cols;
+            header.height = frame.rows;
+            header.type = frame.type();
+            header.frameBytes = frame.total() * frame.elemSize();
+        }
+        else if (frame.size() != Size(header.width, header.height) || frame.type() != header.type) {
+            ok = false;
+            break;
+        }
+        
+        // Pad to the next page, then write the pixels
+        uint64_t start = (pos + FRAME_ALIGN - 1) / FRAME_ALIGN * FRAME_ALIGN;
+        fwrite(padding.data(), 1, start - pos, out);
+        if (!frame.isContinuous()) frame = frame.clone();
+        fwrite(frame.data, 1, header.frameBytes, out);
+        pos = start + header.frameBytes;
+        
+        FrameCacheEntry entry;
+        entry.offset = start;
+        entry.timestamp = cap.get(CV_CAP_PROP_POS_MSEC);
+        index.push_back(entry);
+    }
+    
+    header.numFrames = (int32_t)index.size();
+    header.indexOffset = (pos + 7) / 8 * 8;
+    fwrite(padding.data(), 1, header.indexOffset - pos, out);
+    fwrite(index.data(), sizeof(FrameCacheEntry), index.size(), out);
+    fseek(out, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, out);
+    ok = ok && !ferror(out) && !index.empty();
+    fclose(out);
+    if (!ok) remove(cachePath.c_str());
+    return ok;
+}
+
+string FrameCache::pathFor(string videoPath) {
+    // The usual name of a video's cache: the same, with the extension .etframes
+    return videoPath.substr(0, videoPath.find_last_of('.')) + ".etframes";
+}
+
+
+// * * * * * * * * * * * * * * *
+//      MappedFrameSource
+// * * * * * * * * * * * * * * *
+
+MappedFrameSource::MappedFrameSource(string path) {
+    memset(&header, 0, sizeof(header));
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(header)) {
+        length = st.st_size;
+        void * map = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) data = (uint8_t *)map;
+    }
+    ::close(fd);    // The mapping stays valid
+    if (data == NULL) return;
+    
+    // Check that the header, index and frames all lie within the file
+    memcpy(&header, data, sizeof(header));
+    bool valid = memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0 && header.numFrames > 0 &&
+                 header.frameBytes == (uint64_t)header.width * header.height * CV_ELEM_SIZE(header.type) &&
+                 header.indexOffset + header.numFrames * sizeof(FrameCacheEntry) <= length;
+    if (valid) {
+        index = (const FrameCacheEntry *)(data + header.indexOffset);
+        for (int i = 0; i < header.numFrames && valid; i++) {
+            valid = index[i].offset + header.frameBytes <= length;
+        }
+    }
+    if (!valid) {
+        munmap(data, length);
+        data = NULL;
+        index = NULL;
+    }
+}
+
+MappedFrameSource::~MappedFrameSource() {
+    if (data != NULL) munmap(data, length);
+}
+
+Mat MappedFrameSource::frame(int i) const {
+    // Frame i, over the mapped pixels (valid while the source is open), or empty
+    if (data == NULL || i < 0 || i >= header.numFrames) return Mat();
+    return Mat(header.height, header.width, header.type, data + index[i].offset);
+}
+
+bool MappedFrameSource::read(Mat & frame) {
+    frame = this->frame(next);
+    if (frame.empty()) return false;
+    next++;
+    return true;
+}
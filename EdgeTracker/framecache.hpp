@@ -0,0 +1,102 @@
+//
+//  framecache.hpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#ifndef framecache_hpp
+#define framecache_hpp
+
+#include <opencv2/core/core.hpp>
+#include <iostream>
+#include <vector>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "sources.hpp"
+
+using namespace std;
+using namespace cv;
+
+
+// * * * * * * * * * * * * * * *
+//      FrameCacheHeader
+// * * * * * * * * * * * * * * *
+
+struct FrameCacheHeader {
+    char magic[8];          // "ETFRAME"
+    int32_t width, height;
+    int32_t type;           // OpenCV type of the frames (CV_8UC3)
+    int32_t numFrames;
+    double fps;             // Of the original video (0 if unknown)
+    uint64_t frameBytes;    // Bytes of pixels per frame
+    uint64_t indexOffset;   // Where the index starts
+};
+
+struct FrameCacheEntry {
+    uint64_t offset;        // Where the frame's pixels start
+    double timestamp;       // Its time in the original video (ms)
+};
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+//      Decodes a video once into a file of raw frames, so that it can
+//      be replayed from memory without decoding it again
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+class FrameCache {
+public:
+    static bool build(string videoPath, string cachePath, int maxFrames = 0);
+    static string pathFor(string videoPath);
+    
+/*
+ CONSTANTS
+ */
+public:
+    static const int FRAME_ALIGN = 4096;    // Frames start on page boundaries
+    
+};
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+//      Reads the frames of a cache straight from a memory mapping of
+//      it: each frame is a Mat over the mapped pixels (nothing is
+//      copied or decoded), and any frame can be reached at once.
+//      The mapping is private, so the frames can be drawn on without
+//      changing the file.
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+class MappedFrameSource : public FrameSource {
+public:
+    MappedFrameSource(string path);
+    ~MappedFrameSource();
+    bool isOpened() const {return data != NULL;}
+    bool read(Mat & frame);
+    Mat frame(int i) const;
+    void seek(int i) {next = i;}
+    int getFrameCount() const {return header.numFrames;}
+    double getFps() const {return header.fps;}
+    double getTimestamp(int i) const {return index[i].timestamp;}
+    Size getSize() const {return Size(header.width, header.height);}
+    
+private:
+    uint8_t * data = NULL;
+    size_t length = 0;
+    FrameCacheHeader header;
+    const FrameCacheEntry * index = NULL;   // Into the mapping
+    int next = 0;
+};
+
+
+/*
+
+ File format (native byte order):
+
+    FrameCacheHeader
+    each frame's pixels, row by row with no padding, starting on a
+        multiple of FRAME_ALIGN bytes
+    numFrames x FrameCacheEntry, from indexOffset
+
+ */
+
+#endif /* framecache_hpp */
@@ -0,0 +1,54 @@
+//
+//  framecontext.cpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#include <algorithm>
+
+#include "framecontext.hpp"
+
+
+// * * * * * * * * * * * * * * *
+//      BufferPool
+// * * * * * * * * * * * * * * *
+
+Mat BufferPool::acquire(Size size, int type) {
+    // Returns a buffer of the given size and type that is referenced only by the pool
+    for (int i = 0; i < buffers.size(); i++) {
+        Mat & b = buffers[i];
+        if (b.size() != size || b.type() != type) continue;
+        if (CV_XADD(&b.u->refcount, 0) == 1) return b;
+    }
+    
+    // Forget buffers of other sizes, e.g. after the source changed resolution
+    buffers.erase(remove_if(buffers.begin(), buffers.end(), [&](const Mat & b) {return b.size() != size || b.type() != type;}), buffers.end());
+    buffers.push_back(Mat(size, type));
+    return buffers.back();
+}
+
+
+// * * * * * * * * * * * * * * *
+//      FrameContext
+// * * * * * * * * * * * * * * *
+
+void FrameContext::prepare(Size size_in, int type_in) {
+    // Called before each frame. The image buffers are not allocated here: each is
+    // created by whichever step writes it, so only those of the active path exist,
+    // and reused (create() does nothing) while the frame size and type stay the same.
+    if (size_in == size && type_in == type) return;
+    size = size_in;
+    type = type_in;
+    if (cross.empty()) cross = getStructuringElement(MORPH_CROSS, Size(3,3));
+}
+
+void FrameContext::reserveWhiskers(int numWhiskers) {
+    // Makes room for at least numWhiskers matches, growing in steps to avoid reallocating often
+    if (numWhiskers <= whiskerModel.cols) return;
+    int capacity = max(numWhiskers, 2*whiskerModel.cols);
+    whiskerModel.create(4, capacity, CV_32FC1);
+    targetPoints.create(capacity, 2, CV_32FC1);
+    targetPrior.create(capacity, 1, CV_32FC1);
+}
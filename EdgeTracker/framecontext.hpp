@@ -0,0 +1,72 @@
+//
+//  framecontext.hpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#ifndef framecontext_hpp
+#define framecontext_hpp
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <iostream>
+#include <stdio.h>
+
+#include "asm.hpp"
+#include "bitedges.hpp"
+
+using namespace std;
+using namespace cv;
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+//      Hands out image buffers, reusing any that nobody else still
+//      holds, so that frames passed on to other threads (e.g. the
+//      display) stay valid without allocating a new buffer per frame
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+class BufferPool {
+public:
+    Mat acquire(Size size, int type);
+    
+private:
+    vector<Mat> buffers;
+};
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+//      The working buffers for processing one stream's frames. Each is
+//      allocated by the first frame that uses it, and reused after.
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+class FrameContext {
+public:
+    void prepare(Size size, int type);
+    void reserveWhiskers(int numWhiskers);
+    
+public:
+    Mat scaled;         // The frame at a lower resolution (pyramid levels > 0 only)
+    Mat blurred;        // The blurred frame
+    Mat canny;          // Canny edges
+    Mat dilated;        // Dilated edges (line iterator search only)
+    BitEdgeMap bitEdges;// The dilated edges at 1 bit per pixel (bit-packed search only)
+    Mat orientation;    // Gradient direction at each edge pixel, degrees 0-179 (fused preprocessing only)
+    Mat magnitude;      // L1 gradient magnitude of the blurred luma, CV_16SC1 (sub-pixel search only)
+    Mat edgePoints;     // Coordinates of the edge pixels (point search only)
+    Mat hueDist, hueGradX, hueGradY;    // Hue distance from the current model's colour, and its gradients (colour term only)
+    Mat regionDist, regionGradX, regionGradY;   // Signed distance to the current model's colour region, and its gradients (region refinement only)
+    Mat cross;          // Structuring element for the dilation
+    
+    // Whisker matches of the current iteration; only the first n columns / rows are used
+    vector<vector<EdgeCandidate>> whiskerHits;  // Per whisker: its matches, before they are gathered
+    Mat whiskerModel;   // 4 x capacity: model points of the matched whiskers
+    Mat targetPoints;   // capacity x 2: their matched edge points
+    Mat targetPrior;    // capacity x 1: prior weight of each match (multiple candidates only)
+    vector<int> targetWhisker;  // Which whisker each match belongs to (multiple candidates only)
+    
+private:
+    Size size;
+    int type = -1;
+};
+
+#endif /* framecontext_hpp */
@@ -0,0 +1,114 @@
+//
+//  hough.cpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#include <algorithm>
+
+#include "hough.hpp"
+
+
+vector<Vec4i> ProgressiveHough::find(Mat edges, int numLines, int minVotes, double minLength, double maxGap) {
+    // Returns up to numLines segments (x1, y1, x2, y2), strongest first.
+    // edges: edge map, non-zero on an edge (CV_8UC1)
+    // minLength: shortest segment (px) kept
+    // maxGap: largest gap (px) between the points along one segment
+    setSize(edges.size());
+    accumulator.setTo(0);
+    findNonZero(edges, points);
+    claimed.assign(points.size(), false);
+    for (int i = 0; i < points.size(); i++) vote(points[i], 1);
+    
+    vector<Vec4i> lines;
+    votes.clear();
+    while ((int)lines.size() < numLines) {
+        double maxVotes;
+        Point maxCell;
+        minMaxLoc(accumulator, NULL, &maxVotes, NULL, &maxCell);
+        if (maxVotes < minVotes) break;
+        int a = maxCell.y;
+        int r = maxCell.x;
+        
+        // The cell's points, and the line that fits them
+        cell.clear();
+        segment.clear();
+        for (int i = 0; i < points.size(); i++) {
+            if (claimed[i] || rhoIndex(points[i], a) != r) continue;
+            cell.push_back(make_pair(0.0f, i));
+            segment.push_back(points[i]);
+        }
+        Vec4f fit;
+        fitLine(segment, fit, DIST_HUBER, 0, 0.01, 0.01);
+        Point2f dir = Point2f(fit[0], fit[1]);
+        Point2f origin = Point2f(fit[2], fit[3]);
+        
+        // Those on that line (a cell is rhoRes wide), in order along it
+        int numOn = 0;
+        for (int k = 0; k < cell.size(); k++) {
+            Point2f d = Point2f(points[cell[k].second]) - origin;
+            if (fabs(d.cross(dir)) <= MAX_DISTANCE) cell[numOn++] = make_pair(d.dot(dir), cell[k].second);
+        }
+        cell.resize(numOn);
+        sort(cell.begin(), cell.end());
+        
+        // The longest run of them with no gap over maxGap
+        int bestStart = 0, bestEnd = 0;
+        float bestLength = -1;
+        for (int start = 0, end = 1; end <= cell.size(); end++) {
+            if (end < cell.size() && cell[end].first - cell[end - 1].first <= maxGap) continue;
+            float length = cell[end - 1].first - cell[start].first;
+            if (length > bestLength) {
+                bestLength = length;
+                bestStart = start;
+                bestEnd = end;
+            }
+            start = end;
+        }
+        if (bestLength < minLength) {
+            // Too short to be a line: never take this cell again
+            accumulator.at<int>(a, r) = 0;
+            continue;
+        }
+        
+        // End it level with the run's first and last points
+        Point2f p1 = origin + dir * cell[bestStart].first;
+        Point2f p2 = origin + dir * cell[bestEnd - 1].first;
+        lines.push_back(Vec4i(cvRound(p1.x), cvRound(p1.y), cvRound(p2.x), cvRound(p2.y)));
+        votes.push_back((int)maxVotes);
+        
+        // Take its points' votes back out
+        for (int k = bestStart; k < bestEnd; k++) {
+            claimed[cell[k].second] = true;
+            vote(points[cell[k].second], -1);
+        }
+    }
+    return lines;
+}
+
+void ProgressiveHough::setSize(Size size_in) {
+    // (Re)builds the tables and accumulator, if the image size has changed
+    if (size_in == size && !accumulator.empty()) return;
+    size = size_in;
+    numAngles = cvRound(CV_PI / thetaRes);
+    cosTable.resize(numAngles);
+    sinTable.resize(numAngles);
+    for (int a = 0; a < numAngles; a++) {
+        cosTable[a] = cos(a * thetaRes) / rhoRes;
+        sinTable[a] = sin(a * thetaRes) / rhoRes;
+    }
+    
+    // rho runs from -diagonal to +diagonal
+    int maxRho = cvCeil(sqrt((double)size.width * size.width + (double)size.height * size.height) / rhoRes);
+    rhoOffset = maxRho;
+    accumulator.create(numAngles, 2*maxRho + 1, CV_32SC1);
+}
+
+void ProgressiveHough::vote(Point p, int delta) {
+    // Adds delta to every cell of the lines through p
+    int * acc = (int *)accumulator.data;
+    int numRho = accumulator.cols;
+    for (int a = 0; a < numAngles; a++, acc += numRho) acc[rhoIndex(p, a)] += delta;
+}
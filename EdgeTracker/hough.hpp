@@ -0,0 +1,66 @@
+//
+//  hough.hpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#ifndef hough_hpp
+#define hough_hpp
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <iostream>
+#include <stdio.h>
+
+using namespace std;
+using namespace cv;
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+//      Finds line segments in an edge map from a single Hough transform.
+//      The accumulator is filled once; lines are then taken from it in
+//      order of their votes, strongest first, and the votes of each
+//      line's points are taken back out before the next one is found,
+//      so no line is found twice. It stops at the number asked for.
+//      The buffers are kept from call to call.
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+class ProgressiveHough {
+    
+/*
+ METHODS
+ */
+public:
+    ProgressiveHough(double rhoRes_in = 5, double thetaRes_in = CV_PI/180) : rhoRes(rhoRes_in), thetaRes(thetaRes_in) {}
+    vector<Vec4i> find(Mat edges, int numLines, int minVotes = MIN_VOTES, double minLength = 50, double maxGap = 30);
+    vector<int> getVotes() const {return votes;}
+    
+private:
+    void setSize(Size size_in);
+    int rhoIndex(Point p, int a) const {return cvRound(p.x * cosTable[a] + p.y * sinTable[a]) + rhoOffset;}
+    void vote(Point p, int delta);
+    
+private:
+    double rhoRes, thetaRes;
+    Size size;
+    int numAngles = 0;
+    int rhoOffset = 0;                  // Index of rho = 0
+    vector<float> cosTable, sinTable;   // Per angle, divided by the rho resolution
+    Mat accumulator;                    // Votes, numAngles x no. of rho cells (CV_32SC1)
+    vector<Point> points;               // Edge points
+    vector<bool> claimed;               // Per edge point: whether it is part of a line already found
+    vector<pair<float, int>> cell;      // The unclaimed points of a cell, by position along its line
+    vector<Point2f> segment;            // The same points, to fit the line to
+    vector<int> votes;                  // Of each line found by the last call
+    
+/*
+ CONSTANTS
+ */
+public:
+    static const int MIN_VOTES = 5;     // Weaker lines are never taken
+    static constexpr float MAX_DISTANCE = 1;    // Points further (px) from a cell's fitted line are not part of it
+    
+};
+
+#endif /* hough_hpp */
@@ -0,0 +1,186 @@
+//
+//  logger.cpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <string.h>
+
+#include "logger.hpp"
+
+static const char MAGIC[8] = "ETLOG01";
+
+
+// * * * * * * * * * * * * * * *
+//      Writing
+// * * * * * * * * * * * * * * *
+
+bool PoseLogger::open(string path, int numModels) {
+    close();
+    file = fopen(path.c_str(), "wb");
+    if (file == NULL) return false;
+    
+    int32_t header[2] = {numModels, NUM_COLUMNS};
+    fwrite(MAGIC, 1, sizeof(MAGIC), file);
+    fwrite(header, sizeof(int32_t), 2, file);
+    for (int c = 0; c < NUM_COLUMNS; c++) {
+        char name[16] = {0};
+        strncpy(name, columnName(c), sizeof(name) - 1);
+        fwrite(name, 1, sizeof(name), file);
+    }
+    
+    ring.reset(new RingBuffer<PoseRecord, 1 << 14>());
+    dropped = 0;
+    running = true;
+    writer = thread(&PoseLogger::run, this);
+    return true;
+}
+
+void PoseLogger::close() {
+    // Writes everything still queued, then closes the file
+    if (file == NULL) return;
+    running = false;
+    if (writer.joinable()) writer.join();
+    fclose(file);
+    file = NULL;
+    if (dropped > 0) cout << "PoseLogger: dropped " << dropped << " records" << endl;
+}
+
+void PoseLogger::log(int frame, int model, double time, double errorArea, const estimate & est) {
+    // Called from the tracking thread only. Never blocks: if the writer has fallen
+    // so far behind that the ring is full, the record is counted and dropped.
+    if (file == NULL) return;
+    PoseRecord r;
+    r.frame = frame;
+    r.model = model;
+    r.values[LOG_TIME] = time;
+    r.values[LOG_ERROR_AREA] = errorArea;
+    r.values[LOG_ERROR_LSQ] = est.error;
+    r.values[LOG_ITERATIONS] = est.iterations;
+    for (int i = 0; i < 6; i++) r.values[LOG_X + i] = est.pose[i];
+    if (!ring->push(r)) dropped.fetch_add(1, memory_order_relaxed);
+}
+
+void PoseLogger::run() {
+    // The writer thread: gathers records into blocks and writes each block column by column
+    auto lastWrite = chrono::steady_clock::now();
+    block.reserve(BLOCK_SIZE);
+    
+    while (true) {
+        bool stopping = !running.load();
+        PoseRecord r;
+        while (block.size() < BLOCK_SIZE && ring->pop(r)) block.push_back(r);
+        
+        auto now = chrono::steady_clock::now();
+        bool due = chrono::duration_cast<chrono::milliseconds>(now - lastWrite).count() >= FLUSH_INTERVAL;
+        if (block.size() == BLOCK_SIZE || (!block.empty() && (due || stopping))) {
+            writeBlock();
+            lastWrite = now;
+        }
+        
+        if (stopping && ring->empty() && block.empty()) break;
+        if (ring->empty()) this_thread::sleep_for(chrono::milliseconds(1));
+    }
+}
+
+void PoseLogger::writeBlock() {
+    int32_t n = (int32_t)block.size();
+    vector<int32_t> ints(n);
+    vector<float> floats(n);
+    
+    fwrite(&n, sizeof(int32_t), 1, file);
+    for (int i = 0; i < n; i++) ints[i] = block[i].frame;
+    fwrite(ints.data(), sizeof(int32_t), n, file);
+    for (int i = 0; i < n; i++) ints[i] = block[i].model;
+    fwrite(ints.data(), sizeof(int32_t), n, file);
+    for (int v = 0; v < NUM_LOG_VALUES; v++) {
+        for (int i = 0; i < n; i++) floats[i] = block[i].values[v];
+        fwrite(floats.data(), sizeof(float), n, file);
+    }
+    fflush(file);
+    block.clear();
+}
+
+const char * PoseLogger::columnName(int c) {
+    static const char * names[NUM_COLUMNS] = {
+        "frame", "model", "time", "errorArea", "errorLSQ", "iterations", "x", "y", "z", "rx", "ry", "rz"
+    };
+    return (c >= 0 && c < NUM_COLUMNS) ? names[c] : "";
+}
+
+
+// * * * * * * * * * * * * * * *
+//      Converting
+// * * * * * * * * * * * * * * *
+
+bool PoseLogger::toCSV(string logPath, string csvPath) {
+    // Converts a log to the semicolon-separated layout of the old CSV logs:
+    // one row per frame, with the errors and pose of each model in turn
+    FILE * in = fopen(logPath.c_str(), "rb");
+    if (in == NULL) return false;
+    
+    char magic[8];
+    int32_t header[2];
+    if (fread(magic, 1, sizeof(magic), in) != sizeof(magic) || memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 ||
+        fread(header, sizeof(int32_t), 2, in) != 2 || header[1] != NUM_COLUMNS) {
+        fclose(in);
+        return false;
+    }
+    int numModels = header[0];
+    fseek(in, NUM_COLUMNS * 16, SEEK_CUR);
+    
+    // Gather the records of each frame
+    map<int, vector<PoseRecord>> frames;
+    int32_t n;
+    while (fread(&n, sizeof(int32_t), 1, in) == 1 && n > 0) {
+        vector<PoseRecord> records(n);
+        vector<int32_t> ints(n);
+        vector<float> floats(n);
+        bool ok = fread(ints.data(), sizeof(int32_t), n, in) == (size_t)n;
+        for (int i = 0; i < n; i++) records[i].frame = ints[i];
+        ok = ok && fread(ints.data(), sizeof(int32_t), n, in) == (size_t)n;
+        for (int i = 0; i < n; i++) records[i].model = ints[i];
+        for (int v = 0; v < NUM_LOG_VALUES; v++) {
+            ok = ok && fread(floats.data(), sizeof(float), n, in) == (size_t)n;
+            for (int i = 0; i < n; i++) records[i].values[v] = floats[i];
+        }
+        if (!ok) break;     // Truncated block, e.g. the tracker was killed
+        for (int i = 0; i < n; i++) frames[records[i].frame].push_back(records[i]);
+    }
+    fclose(in);
+    
+    ofstream out(csvPath);
+    if (!out.is_open()) return false;
+    out << "Time";
+    for (int m = 0; m < numModels; m++) out << ";error_Area_ " << m << ";error_LSQ_ " << m << ";tX_ " << m << ";tY_ " << m << ";tZ_ " << m << ";rX_ " << m << ";rY_ " << m << ";rZ_ " << m;
+    out << "\n";
+    
+    for (auto & f : frames) {
+        vector<const PoseRecord *> byModel(numModels, NULL);
+        for (int i = 0; i < f.second.size(); i++) {
+            int m = f.second[i].model;
+            if (m >= 0 && m < numModels) byModel[m] = &f.second[i];
+        }
+        out << f.second[0].values[LOG_TIME];
+        for (int m = 0; m < numModels; m++) {
+            const PoseRecord * r = byModel[m];
+            if (r == NULL) {
+                out << ";;;;;;;;";
+                continue;
+            }
+            if (!isnan(r->values[LOG_ERROR_AREA])) out << ";" << r->values[LOG_ERROR_AREA];
+            else out << ";";
+            out << ";" << r->values[LOG_ERROR_LSQ];
+            for (int i = 0; i < 6; i++) out << ";" << r->values[LOG_X + i];
+        }
+        out << "\n";
+    }
+    
+    return true;
+}
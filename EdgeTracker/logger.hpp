@@ -0,0 +1,108 @@
+//
+//  logger.hpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#ifndef logger_hpp
+#define logger_hpp
+
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "lsq.hpp"
+#include "ring.hpp"
+
+using namespace std;
+
+
+// * * * * * * * * * * * * * * *
+//      PoseRecord
+// * * * * * * * * * * * * * * *
+
+enum LogValue {
+    LOG_TIME,           // Frame processing time (ms)
+    LOG_ERROR_AREA,
+    LOG_ERROR_LSQ,
+    LOG_ITERATIONS,
+    LOG_X, LOG_Y, LOG_Z, LOG_RX, LOG_RY, LOG_RZ,
+    NUM_LOG_VALUES
+};
+
+struct PoseRecord {
+    int32_t frame;
+    int32_t model;
+    float values[NUM_LOG_VALUES];
+};
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+//      Logs one record per model per frame without blocking the
+//      tracking thread: records go through a lock-free ring to a
+//      background thread, which writes them to a columnar binary file
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+class PoseLogger {
+    
+/*
+ METHODS
+ */
+public:
+    PoseLogger() : file(NULL), running(false), dropped(0) {}
+    ~PoseLogger() {close();}
+    bool open(string path, int numModels);
+    void close();
+    bool isOpen() const {return file != NULL;}
+    void log(int frame, int model, double time, double errorArea, const estimate & est);
+    long long getDropped() const {return dropped.load();}
+    static bool toCSV(string logPath, string csvPath);
+    static const char * columnName(int c);
+    
+private:
+    void run();
+    void writeBlock();
+    
+private:
+    FILE * file;
+    unique_ptr<RingBuffer<PoseRecord, 1 << 14>> ring;
+    thread writer;
+    atomic<bool> running;
+    atomic<long long> dropped;
+    vector<PoseRecord> block;       // Records waiting to be written (writer thread only)
+    
+/*
+ CONSTANTS
+ */
+public:
+    static const int NUM_COLUMNS = 2 + NUM_LOG_VALUES;
+    static const int BLOCK_SIZE = 1024;         // Max records per block of columns
+    static const int FLUSH_INTERVAL = 1000;     // Max time (ms) a record waits to be written
+    
+};
+
+
+/*
+
+ File format (native byte order):
+
+    char[8]     "ETLOG01"
+    int32       No. of models
+    int32       No. of columns
+    char[16]    Name of each column ("frame", "model", "time", "errorArea", ...)
+
+ then any number of blocks, each:
+
+    int32       No. of records n
+    n x int32   frame
+    n x int32   model
+    n x float   each of the NUM_LOG_VALUES values in turn
+
+ */
+
+#endif /* logger_hpp */
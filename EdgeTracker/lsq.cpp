@@ -6,105 +6,256 @@
 //  Copyright © 2018 Daniel Mesham. All rights reserved.
 //
 
+#include <cfloat>
+
 #include "lsq.hpp"
+#include "threadpool.hpp"
 
 const float lsq::ERROR_THRESHOLD = 0.5;
+const float lsq::MIN_IMPROVEMENT = 0.01;
+const float lsq::SOFT_SIGMA_START = 8;
+const float lsq::SOFT_SIGMA_MIN = 1.5;
+const float lsq::SOFT_SIGMA_DECAY = 0.7;
+const float lsq::SOFT_OUTLIER = 0.01;
 
-estimate lsq::poseEstimateLM(Vec6f pose1, Mat model, Mat target, Mat K, int maxIter) {
+estimate lsq::poseEstimateLM(Vec6f pose1, Mat model, Mat target, Mat K, int maxIter, ThreadPool * pool, const Distortion * dist) {
     // pose1: imitial pose parameters
     // model: model points in full homogeneous coords
     // target: image points, in 2D coords
     // K: intrinsic matrix
     // maxIter: max no of iterations, default if 0
-    // rotOrder: order of rotations, default XYZ
+    // pool: workers to share the normal equations with (serial if NULL)
+    // dist: lens distortion of the image points (none if NULL)
+    //
+    // The pose is solved as an SE3, each step being a twist applied on the left
+    // (see se3.hpp), so it behaves the same at any orientation.
     
     if (maxIter == 0) maxIter = MAX_ITERATIONS;
     
-    Mat y = lsq::projection(pose1, model, K);
+    SE3 T = SE3::fromPose(pose1);
+    Mat y = lsq::projection(T, model, K, dist);
     float E = lsq::projectionError(target, y);
     
     int iterations = 0;
     while (E > ERROR_THRESHOLD && iterations < maxIter) {
-        Mat J = lsq::jacobian(pose1, model, K);
+        Mat JtJ, Jte;
+        lsq::normalEquations(T, model, target, K, JtJ, Jte, pool, dist);
+        Mat del = -JtJ.inv() * Jte;
+        
+        SE3 T2 = SE3::exp(Vec6f((float *)del.data)) * T;
+        
+        Mat y2 = lsq::projection(T2, model, K, dist);
+        float E2 = lsq::projectionError(target, y2);
+        iterations++;
+        
+        // Keep the previous pose if the step made things worse, and stop
+        // once the steps stop paying for themselves
+        if (E2 >= E) break;
+        float improvement = (E - E2)/E;
+        y = y2;
+        E = E2;
+        T = T2;
+        if (improvement < MIN_IMPROVEMENT) break;
+    }
+    
+    return estimate(T.toPose(), E, iterations);
+}
+
+void lsq::normalEquations(const SE3 & pose, Mat model, Mat target, Mat K, Mat & JtJ, Mat & Jte, ThreadPool * pool, const Distortion * dist) {
+    // Builds the Gauss-Newton normal equations J'J and J'e of the point-distance error.
+    // With a pool, the points are split into chunks whose partial sums are built in
+    // parallel and added up at the end (in chunk order, so the result doesn't depend
+    // on the scheduling).
+    JtJ = Mat::zeros(6, 6, CV_32FC1);
+    Jte = Mat::zeros(6, 1, CV_32FC1);
+    int n = model.cols;
+    if (n == 0) return;
+    int numChunks = pool == NULL ? 1 : (n + PARALLEL_CHUNK - 1) / PARALLEL_CHUNK;
+    int chunk = (n + numChunks - 1) / numChunks;
+    vector<Mat> partJtJ(numChunks), partJte(numChunks);
+    
+    auto accumulate = [&](int begin, int end) {
+        Mat x = model.colRange(begin, end);
+        Mat J = lsq::jacobian(pose, x, K, dist);
+        Mat y = lsq::projection(pose, x, K, dist);
         Mat eps;
-        subtract(y.rowRange(0, 2).t(), target, eps);
+        subtract(y.rowRange(0, 2).t(), target.rowRange(begin, end), eps);
         eps = lsq::pointsAsCol(eps.t());
         for (int i = 0; i < eps.rows; i++) {
             if (eps.at<float>(i) > 20) eps.at<float>(i) = 20;
         }
-        Mat Jp = J.t() * J;
-        Jp = -Jp.inv() * J.t();
-        Mat del = Jp * eps;
+        int c = begin / chunk;
+        partJtJ[c] = J.t() * J;
+        partJte[c] = J.t() * eps;
+    };
+    
+    if (pool == NULL || numChunks == 1) accumulate(0, n);
+    else pool->parallelFor(n, chunk, accumulate);
+    
+    for (int c = 0; c < numChunks; c++) {
+        if (partJtJ[c].empty()) continue;
+        JtJ += partJtJ[c];
+        Jte += partJte[c];
+    }
+}
+
+/*
+ Method for several candidate targets per model point, weighted softly (EM-style).
+ */
+estimate lsq::poseEstimateSoft(Vec6f pose1, Mat model, Mat target, Mat prior, const vector<int> & group, Mat K, int maxIter, const Distortion * dist) {
+    // pose1: imitial pose parameters
+    // model: model points in full homogeneous coords, one column per candidate
+    //        (i.e. a model point is repeated for each of its candidates)
+    // target: candidate image points, in 2D coords
+    // prior: the prior weight of each candidate (e.g. EdgeCandidate::score)
+    // group: which model point (whisker) each candidate belongs to; a group's
+    //        candidates must be consecutive
+    // K: intrinsic matrix
+    // maxIter: max no of iterations, default if 0
+    // dist: lens distortion of the image points (none if NULL)
+    //
+    // Each iteration the candidates of a group share its weight according to how
+    // close they are to the current projection (E-step), then one weighted Gauss-
+    // Newton step is taken (M-step). The spread of the weights shrinks as the
+    // pose settles, so the candidates are reweighted rather than searched again.
+    
+    if (maxIter == 0) maxIter = MAX_ITERATIONS;
+    int n = model.cols;
+    
+    Mat w = Mat(n, 1, CV_32FC1);
+    float sigma = SOFT_SIGMA_START;
+    
+    // Weights of the candidates at projection y; returns the weighted mean distance
+    auto reweight = [&](Mat y) {
+        Mat d = Mat(n, 1, CV_32FC1);
+        for (int i = 0; i < n; i++) {
+            float ex = y.at<float>(0, i) - target.at<float>(i, 0);
+            float ey = y.at<float>(1, i) - target.at<float>(i, 1);
+            d.at<float>(i) = sqrt(ex*ex + ey*ey);
+        }
+        float sumWD = 0, sumW = 0;
+        for (int start = 0; start < n; ) {
+            int end = start;
+            float total = SOFT_OUTLIER;
+            while (end < n && group[end] == group[start]) {
+                float di = d.at<float>(end);
+                w.at<float>(end) = prior.at<float>(end) * exp(-di*di / (2*sigma*sigma));
+                total += w.at<float>(end);
+                end++;
+            }
+            for (int i = start; i < end; i++) {
+                w.at<float>(i) /= total;
+                sumWD += w.at<float>(i) * d.at<float>(i);
+                sumW += w.at<float>(i);
+            }
+            start = end;
+        }
+        return sumW > 0 ? sumWD / sumW : FLT_MAX;
+    };
+    
+    SE3 T = SE3::fromPose(pose1);
+    Mat y = lsq::projection(T, model, K, dist);
+    float E = reweight(y);
+    
+    int iterations = 0;
+    while (E > ERROR_THRESHOLD && iterations < maxIter) {
+        Mat J = lsq::jacobian(T, model, K, dist);
+        Mat eps;
+        subtract(y.rowRange(0, 2).t(), target, eps);
+        eps = lsq::pointsAsCol(eps.t());
+        for (int i = 0; i < eps.rows; i++) {
+            eps.at<float>(i) = min(max(eps.at<float>(i), -20.f), 20.f);
+        }
         
-        Vec6f pose2 = pose1;
-        for (int i = 0; i < 6; i++) {
-            pose2[i] += del.at<float>(i);
+        // Weight both coordinates of each candidate
+        Mat WJ = J.clone();
+        for (int i = 0; i < 2*n; i++) {
+            Mat r = WJ.row(i);
+            r *= w.at<float>(i/2);
         }
         
-        y = lsq::projection(pose2, model, K);
-        E = lsq::projectionError(target, y);
+        Mat del;
+        if (!solve(J.t() * WJ, -WJ.t() * eps, del, DECOMP_CHOLESKY)) break;
         
-        pose1 = pose2;
+        T = SE3::exp(Vec6f((float *)del.data)) * T;
         iterations++;
+        
+        // Tighten the weights, and stop once they have settled and the steps stop paying
+        bool settled = sigma <= SOFT_SIGMA_MIN;
+        sigma = max(SOFT_SIGMA_MIN, sigma * SOFT_SIGMA_DECAY);
+        y = lsq::projection(T, model, K, dist);
+        float E2 = reweight(y);
+        float improvement = (E - E2)/E;
+        E = E2;
+        if (settled && improvement < MIN_IMPROVEMENT) break;
     }
     
-    return estimate(pose1, E, iterations);
+    return estimate(T.toPose(), E, iterations);
 }
 
 /*
  Method for optimising point-distance errors as well as colour errors.
  */
-estimate lsq::poseEstimateLM(Vec6f pose1, Mat model, Mat target, Mat K, Mat imgHue, Scalar colour, Mat colourPoints, float alpha, int maxIter) {
+estimate lsq::poseEstimateLM(Vec6f pose1, Mat model, Mat target, Mat K, Mat hueDist, Mat hueGradX, Mat hueGradY, Mat colourPoints, float alpha, int maxIter, const Distortion * dist) {
     // pose1: imitial pose parameters
     // model: model points in full homogeneous coords
     // target: image points, in 2D coords
     // K: intrinsic matrix
-    // imgHue: the Hue channel of the HSV image
-    // colour: the expected colour of certain points
-    // colourPoints: the points that should have the colour provided
+    // hueDist, hueGradX, hueGradY: the smoothed hue distance from the model's colour,
+    //                              and its gradients (see orange::hueDistance)
+    // colourPoints: points (model coords) that should have the model's colour
     // alpha: the weighting between distance errors (0) and colour errors (1)
     // maxIter: max no of iterations, default if 0
+    // dist: lens distortion of the image (none if NULL)
     
     if (maxIter == 0) maxIter = MAX_ITERATIONS;
     
-    Mat bgr(1 ,1 , CV_8UC3, colour);
-    Mat3b hsv;
-    cvtColor(bgr, hsv, COLOR_BGR2HSV);
-    int hue = hsv.at<int>(0,0);
-    
-    Mat y = lsq::projection(pose1, model, K);
-    Mat yC = lsq::projection(pose1, colourPoints, K);
-    float E = (1-alpha)*lsq::projectionError(target, y) + (alpha)*pow(lsq::colourError(imgHue, yC, hue), 2);
-    
-    int iterations = 0;
-    while (E > ERROR_THRESHOLD && iterations < maxIter) {
-        Mat J = lsq::jacobian(pose1, model, K) * (1-alpha);cout << J << endl << endl;
-        vconcat(J, alpha*jacobianColour(pose1, colourPoints, K, imgHue), J);
+    // The residuals are scaled so that their sum of squares is the objective,
+    // (1-alpha) * mean(d^2) + alpha * mean(c^2), over the 2n distance components
+    // and the m colour samples. The steps and their acceptance both use it.
+    int n = model.cols;
+    int m = colourPoints.cols;
+    float wD = n > 0 ? sqrt((1 - alpha) / (2 * n)) : 0;
+    float wC = m > 0 ? sqrt(alpha / m) : 0;
+    auto residuals = [&](Mat y, Mat yC) {
         Mat eps;
         subtract(y.rowRange(0, 2).t(), target, eps);
         eps = lsq::pointsAsCol(eps.t());
+        vconcat(eps, lsq::coloursAtPoints(hueDist, yC), eps);
         for (int i = 0; i < eps.rows; i++) {
-            if (eps.at<float>(i) > 20) eps.at<float>(i) = 20;
+            eps.at<float>(i) = min(max(eps.at<float>(i), -20.0f), 20.0f) * (i < 2*n ? wD : wC);
         }
-        vconcat(eps, coloursAtPoints(imgHue, yC) - hue, eps);
+        return eps;
+    };
+    
+    SE3 T = SE3::fromPose(pose1);
+    Mat eps = residuals(lsq::projection(T, model, K, dist), lsq::projection(T, colourPoints, K, dist));
+    float E = eps.dot(eps);
+    
+    int iterations = 0;
+    while (E > ERROR_THRESHOLD && iterations < maxIter) {
+        Mat J = lsq::jacobian(T, model, K, dist) * wD;
+        vconcat(J, lsq::jacobianColour(T, colourPoints, K, hueGradX, hueGradY, dist) * wC, J);
         Mat Jp = J.t() * J;
         Jp = -Jp.inv() * J.t();
         Mat del = Jp * eps;
         
-        Vec6f pose2 = pose1;
-        for (int i = 0; i < 6; i++) {
-            pose2[i] += del.at<float>(i);
-        }
-        
-        y = lsq::projection(pose2, model, K);
-        yC = lsq::projection(pose2, colourPoints, K);
-        E = (1-alpha)*lsq::projectionError(target, y) + (alpha)*pow(lsq::colourError(imgHue, yC, hue), 2);
+        SE3 T2 = SE3::exp(Vec6f((float *)del.data)) * T;
         
-        pose1 = pose2;
+        Mat eps2 = residuals(lsq::projection(T2, model, K, dist), lsq::projection(T2, colourPoints, K, dist));
+        float E2 = eps2.dot(eps2);
         iterations++;
+        
+        // As above: never accept a worse pose, and stop when the steps stop paying
+        if (E2 >= E) break;
+        float improvement = (E - E2)/E;
+        eps = eps2;
+        E = E2;
+        T = T2;
+        if (improvement < MIN_IMPROVEMENT) break;
     }
     
-    return estimate(pose1, E, iterations);
+    return estimate(T.toPose(), E, iterations);
 }
 
 
@@ -139,10 +290,29 @@ Mat lsq::rotation(float x, float y, float z) {
     return rZ * rY * rX;
 }
 
-Mat lsq::projection(Vec6f pose, Mat model, Mat K) {
-    Mat P;
-    hconcat( rotation(pose[3], pose[4], pose[5]) , translation(pose[0], pose[1], pose[2]) , P);
-    Mat y = (K * P) * model;
+Mat lsq::projection(Vec6f pose, Mat model, Mat K, const Distortion * dist) {
+    return projection(SE3::fromPose(pose), model, K, dist);
+}
+
+Mat lsq::projection(const SE3 & pose, Mat model, Mat K, const Distortion * dist) {
+    // With distortion, each point is distorted on the normalised image plane, then
+    // put through K
+    if (dist != NULL) {
+        Mat p = pose.matrix() * model;
+        Matx33f Kx = Mat_<float>(K);
+        Mat y = Mat(3, model.cols, CV_32FC1);
+        for (int i = 0; i < model.cols; i++) {
+            float iz = 1 / p.at<float>(2, i);
+            Point2f d = dist->distortNormalised(Point2f(p.at<float>(0, i) * iz, p.at<float>(1, i) * iz));
+            Vec3f q = Kx * Vec3f(d.x, d.y, 1);
+            y.at<float>(0, i) = q[0];
+            y.at<float>(1, i) = q[1];
+            y.at<float>(2, i) = 1;
+        }
+        return y;
+    }
+    
+    Mat y = (K * pose.matrix()) * model;
     
     Mat z = y.row(2);
     Mat norm;
@@ -167,19 +337,26 @@ float lsq::projectionError(Mat target, Mat proj) {
     return e.at<float>(0) / numPoints;
 }
 
-float lsq::colourError(Mat imgH, Mat points, int hue) {
-    // Returns the sum of the squared errors in the Hue (H) of the image
-    // at the given points
-    // imgH: the Hue (H) channel of the image
-    // points: the points at which to sample the colour
-    // hue: the expected Hue value
-    return 0;
+float lsq::colourError(Mat hueDist, Mat points) {
+    // Returns the mean squared hue distance at the given (projected) points
+    // hueDist: hue distance image (see orange::hueDistance)
+    // points: the projected points at which to sample it, one per column
+    Mat d = coloursAtPoints(hueDist, points);
+    return d.dot(d) / max(d.rows, 1);
 }
 
-Mat lsq::coloursAtPoints(Mat imgHue, Mat points) {
+Mat lsq::coloursAtPoints(Mat img, Mat points) {
+    // Samples a single-channel float image at each (projected) point, bilinearly.
+    // Points outside the image take the value at its border.
     Mat ret = Mat(points.cols, 1, CV_32FC1);
     for (int i = 0; i < points.cols; i++) {
-        ret.at<float>(i, 0) = imgHue.at<u_char>(points.at<float>(0, i), points.at<float>(1, i));
+        float x = min(max(points.at<float>(0, i), 0.f), img.cols - 1.001f);
+        float y = min(max(points.at<float>(1, i), 0.f), img.rows - 1.001f);
+        int x0 = (int)x, y0 = (int)y;
+        float fx = x - x0, fy = y - y0;
+        const float * r0 = img.ptr<float>(y0) + x0;
+        const float * r1 = img.ptr<float>(y0 + 1) + x0;
+        ret.at<float>(i, 0) = (1-fy) * ((1-fx)*r0[0] + fx*r0[1]) + fy * ((1-fx)*r1[0] + fx*r1[1]);
     }
     return ret;
 }
@@ -192,53 +369,66 @@ Mat lsq::pointsAsCol(Mat points) {
     return points;
 }
 
-Mat lsq::jacobian(Vec6f pose, Mat model, Mat K) {
-    // Calculates the Jacobian for the given pose of model x
-    Mat J = Mat(2*model.cols, 0, CV_32FC1);
-    
-    float dt = 1;
-    float dr = CV_PI/180;
-    vector<float> delta = {dt, dt, dt, dr, dr, dr};
+Mat lsq::jacobian(const SE3 & pose, Mat model, Mat K, const Distortion * dist) {
+    // Calculates the Jacobian of the projection of model x with respect to a twist
+    // applied to the given pose (see se3.hpp), analytically.
+    // A camera point p moves by v + w x p, and projects through q = Kp to (q0/q2, q1/q2)
+    // or, with distortion, to K * distort(p0/p2, p1/p2).
+    Mat J = Mat(2*model.cols, 6, CV_32FC1);
+    Matx33f Kx = Mat_<float>(K);
+    Matx22f K2 = Matx22f(Kx(0,0), Kx(0,1), Kx(1,0), Kx(1,1));
     
-    for (int i = 0; i < 6; i++) {
-        Vec6f p1 = pose;
-        p1[i] += delta[i];
-        Vec6f p2 = pose;
-        p2[i] -= delta[i];
-        Mat j = (projection(p1, model, K) - projection(p2, model, K))/delta[i];
-        hconcat(J, pointsAsCol(j), J);
+    for (int i = 0; i < model.cols; i++) {
+        Vec3f x = Vec3f(model.at<float>(0, i), model.at<float>(1, i), model.at<float>(2, i));
+        Vec3f p = pose.R * x + pose.t * model.at<float>(3, i);
+        
+        Matx<float, 2, 3> dp;
+        if (dist == NULL) {
+            // d(u,v)/dp: the perspective division, after K
+            Vec3f q = Kx * p;
+            float iz = 1 / q[2];
+            Matx<float, 2, 3> dq = Matx<float, 2, 3>(iz, 0, -q[0]*iz*iz,
+                                                     0, iz, -q[1]*iz*iz);
+            dp = dq * Kx;
+        }
+        else {
+            // ...or the division, then the distortion, then K
+            float iz = 1 / p[2];
+            Point2f n = Point2f(p[0]*iz, p[1]*iz);
+            Matx<float, 2, 3> dn = Matx<float, 2, 3>(iz, 0, -n.x*iz,
+                                                     0, iz, -n.y*iz);
+            dp = K2 * dist->jacobianNormalised(n) * dn;
+        }
+        
+        // dp/d(v,w) = [I | -hat(p)]
+        for (int r = 0; r < 2; r++) {
+            float * row = J.ptr<float>(2*i + r);
+            row[0] = dp(r,0);
+            row[1] = dp(r,1);
+            row[2] = dp(r,2);
+            row[3] = dp(r,2)*p[1] - dp(r,1)*p[2];
+            row[4] = dp(r,0)*p[2] - dp(r,2)*p[0];
+            row[5] = dp(r,1)*p[0] - dp(r,0)*p[1];
+        }
     }
     
     return J;
 }
 
-Mat lsq::jacobianColour(Vec6f pose, Mat points, Mat K, Mat imgHue) {
-    // Calculates the Jacobian of the Hues at the given points for the given pose of model x.
-    // Each column of 'points' is a point
-    Mat J = Mat(points.cols, 0, CV_32FC1);
-    
-    float dt = 1;
-    float dr = CV_PI/180;
-    vector<float> delta = {dt, dt, dt, dr, dr, dr};
+Mat lsq::jacobianColour(const SE3 & pose, Mat points, Mat K, Mat hueGradX, Mat hueGradY, const Distortion * dist) {
+    // Calculates the Jacobian of the hue distance at the given points for the given pose.
+    // Each column of 'points' is a point (model coords).
+    // By the chain rule, each row is the image gradient at the projected point times
+    // the Jacobian of that point's projection.
+    Mat proj = projection(pose, points, K, dist);
+    Mat Jp = jacobian(pose, points, K, dist);
+    Mat gx = coloursAtPoints(hueGradX, proj);
+    Mat gy = coloursAtPoints(hueGradY, proj);
     
-    for (int i = 0; i < 6; i++) {
-        Vec6f p1 = pose;
-        p1[i] += delta[i];
-        Vec6f p2 = pose;
-        p2[i] -= delta[i];
-        
-        Mat points1 = projection(p1, points, K);
-        Mat points2 = projection(p2, points, K);
-        
-        Mat dC = Mat(points.cols, 1, CV_32FC1); // The colour gradients of each point
-        
-        // For each point calculate the colour gradient
-        for (int j = 0; j < points.cols; j++) {
-            int c1 = imgHue.at<u_char>(points1.at<float>(0, j), points1.at<float>(1, j));
-            int c2 = imgHue.at<u_char>(points2.at<float>(0, j), points2.at<float>(1, j));
-            dC.at<float>(j, 0) = (c1 - c2)/delta[i];
-        }
-        hconcat(J, dC, J);
+    Mat J = Mat(points.cols, 6, CV_32FC1);
+    for (int i = 0; i < points.cols; i++) {
+        Mat row = gx.at<float>(i) * Jp.row(2*i) + gy.at<float>(i) * Jp.row(2*i + 1);
+        row.copyTo(J.row(i));
     }
     
     return J;
@@ -246,30 +436,8 @@ Mat lsq::jacobianColour(Vec6f pose, Mat points, Mat K, Mat imgHue) {
 
 Vec6f lsq::relativePose(Vec6f poseBase, Vec6f poseQuery) {
     // Returns the pose vector of 'poeQuery' relative to 'poseBase'
-    
-    Mat baseP;
-    hconcat( rotation(poseBase[3], poseBase[4], poseBase[5]) , translation(poseBase[0], poseBase[1], poseBase[2]) , baseP);
-    
-    Mat queryP;
-    hconcat( rotation(poseQuery[3], poseQuery[4], poseQuery[5]) , translation(poseQuery[0], poseQuery[1], poseQuery[2]) , queryP);
-    
-    float bottomRow[4] = {0,0,0,1};
-    Mat bottomRowMat = Mat(1, 4, baseP.type(), bottomRow);
-    vconcat(baseP, bottomRowMat, baseP);
-    vconcat(queryP, bottomRowMat, queryP);
-    
-    //Mat relP = queryP * baseP.inv();
-    Mat relP = baseP.inv() * queryP;
-    
-    // Find the angles (thanks to Gregory Slabaugh)
-    float rY = -asin(relP.at<float>(2,0));
-    float rX = atan2(relP.at<float>(2,1), relP.at<float>(2,2));
-    float rZ = atan2(relP.at<float>(1,0), relP.at<float>(0,0));
-    float tX = relP.at<float>(0,3);
-    float tY = relP.at<float>(1,3);
-    float tZ = relP.at<float>(2,3);
-    
-    return {tX, tY, tZ, rX, rY, rZ};
+    SE3 rel = SE3::fromPose(poseBase).inverse() * SE3::fromPose(poseQuery);
+    return rel.toPose();
 }
 
 Vec6f estimate::standardisePose(Vec6f pose) {
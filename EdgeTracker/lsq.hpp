@@ -15,9 +15,14 @@
 #include <iostream>
 #include <stdio.h>
 
+#include "distortion.hpp"
+#include "se3.hpp"
+
 using namespace std;
 using namespace cv;
 
+class ThreadPool;
+
 // * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
 //      A class defining a least squares estimated pose
 // * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
@@ -47,17 +52,20 @@ class lsq {
     METHODS
  */
 public:
-    static estimate poseEstimateLM(Vec6f pose1, Mat x, Mat target, Mat K, int maxIter = MAX_ITERATIONS);
-    static estimate poseEstimateLM(Vec6f pose1, Mat x, Mat target, Mat K, Mat imgHue, Scalar colour, Mat colourPoints, float alpha, int maxIter = MAX_ITERATIONS);
+    static estimate poseEstimateLM(Vec6f pose1, Mat x, Mat target, Mat K, int maxIter = MAX_ITERATIONS, ThreadPool * pool = NULL, const Distortion * dist = NULL);
+    static void normalEquations(const SE3 & pose, Mat x, Mat target, Mat K, Mat & JtJ, Mat & Jte, ThreadPool * pool = NULL, const Distortion * dist = NULL);
+    static estimate poseEstimateLM(Vec6f pose1, Mat x, Mat target, Mat K, Mat hueDist, Mat hueGradX, Mat hueGradY, Mat colourPoints, float alpha, int maxIter = MAX_ITERATIONS, const Distortion * dist = NULL);
+    static estimate poseEstimateSoft(Vec6f pose1, Mat x, Mat target, Mat prior, const vector<int> & group, Mat K, int maxIter = MAX_ITERATIONS, const Distortion * dist = NULL);
     static Mat translation(float x, float y, float z);
     static Mat rotation(float x, float y, float z);
-    static Mat projection(Vec6f pose, Mat x, Mat K);
+    static Mat projection(Vec6f pose, Mat x, Mat K, const Distortion * dist = NULL);
+    static Mat projection(const SE3 & pose, Mat x, Mat K, const Distortion * dist = NULL);
     static float projectionError(Mat target, Mat proj);
-    static float colourError(Mat imgH, Mat points, int hue);
-    static Mat coloursAtPoints(Mat imgHue, Mat points);
+    static float colourError(Mat hueDist, Mat points);
+    static Mat coloursAtPoints(Mat img, Mat points);
     static Mat pointsAsCol(Mat points);
-    static Mat jacobian(Vec6f pose, Mat x, Mat K);
-    static Mat jacobianColour(Vec6f pose, Mat points, Mat K, Mat imgHue);
+    static Mat jacobian(const SE3 & pose, Mat x, Mat K, const Distortion * dist = NULL);
+    static Mat jacobianColour(const SE3 & pose, Mat points, Mat K, Mat hueGradX, Mat hueGradY, const Distortion * dist = NULL);
     static Vec6f relativePose(Vec6f poseBase, Vec6f poseQuery);
         
 /*
@@ -66,6 +74,12 @@ public:
 public:
     static const int MAX_ITERATIONS = 20;
     static const float ERROR_THRESHOLD;
+    static const int PARALLEL_CHUNK = 64;   // Points per task when building the normal equations in parallel
+    static const float MIN_IMPROVEMENT;     // Stop once a step reduces the error by less than this fraction
+    static const float SOFT_SIGMA_START;    // Soft assignment: initial spread (px) of the candidate weights,
+    static const float SOFT_SIGMA_MIN;      //   which shrinks by SOFT_SIGMA_DECAY each iteration down to SOFT_SIGMA_MIN
+    static const float SOFT_SIGMA_DECAY;
+    static const float SOFT_OUTLIER;        // Soft assignment: weight of "none of the candidates" per whisker
 
 };
 
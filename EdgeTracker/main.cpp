@@ -14,15 +14,26 @@
 
 #include "area.hpp"
 #include "asm.hpp"
+#include "budget.hpp"
+#include "display.hpp"
+#include "framecache.hpp"
+#include "framecontext.hpp"
+#include "logger.hpp"
 #include "lsq.hpp"
 #include "models.hpp"
 #include "orange.hpp"
+#include "profiler.hpp"
+#include "scenarios.hpp"
+#include "telemetry.hpp"
+#include "threadpool.hpp"
+#include "tracker.hpp"
 
 #include <iostream>
 #include <fstream>
 #include <chrono>
 #include <ctime>
 #include <iomanip>
+#include <thread>
 
 using namespace std;
 using namespace cv;
@@ -39,21 +50,35 @@ string currentDateTime();
 //      Constants
 // * * * * * * * * * * * * * * * * * * * * * * * * * * * *
 
-// The intrinsic matrix: Mac webcam
-static float intrinsicMatrix[3][3] = {
-    { 1045.8,    0  , 646.7 },
-    {    0  , 1058.8, 350.9 },
-    {    0  ,    0  ,   1   }
-};
-static Mat K = Mat(3,3, CV_32FC1, intrinsicMatrix);
+// The intrinsic matrix, and the data and template folders, are in the scenario catalogue.
+// The camera's lens distortion (k1, k2, p1, p2, k3): all zero for none
+static float distortionCoeffs[5] = { 0, 0, 0, 0, 0 };
+static Mat distortion = Mat(1,5, CV_32FC1, distortionCoeffs);
 
-static string dataFolder = "../../../../../data/";
 static string logFolder = "../../../../../logs/";
+static string scenarioFile = "../../../../EdgeTracker/scenarios.yml";
 
 static bool DEBUGGING = true; // Whether to show the canny and segmented images
-static bool LOGGING = false; // Whether to log data to CSV files
+static bool HEADLESS = false; // Whether to skip all drawing and display (for timing)
+static bool SAVE_VIDEO = false; // Whether to save the annotated frames as a video
+static bool LOGGING = false; // Whether to log data (to a binary log, see LogConverter)
+static bool PUBLISHING = false; // Whether to publish the poses to shared memory for other processes (see PoseTail)
+static bool USE_FRAME_CACHE = false; // Whether to replay a pre-decoded copy of the video (made on first use), so that decoding isn't timed
+static double LIVE_FPS = 0; // Replay the video as a live camera at this rate, always tracking the newest frame (0: track every frame)
 static bool REPORT_ERRORS = true; // Whether to report the area error (slows performance)
+static bool POLYGON_AREA = true; // Whether to measure the area error of planar models from polygons rather than by counting pixels
+static double FRAME_BUDGET = 0; // Target time per frame (ms): tracking is scaled back to meet it (0: no limit)
 static bool USE_LINE_ITER = true; // Whether to use the line iterator technique for the whiskers
+static bool USE_FUSED_EDGES = true; // Whether to find the edges in one fused, parallel pass (false: separate OpenCV calls)
+static bool USE_COLOUR_EDGES = false; // Whether to use the edges of each colour channel rather than of the brightness
+static bool USE_BIT_EDGES = false; // Whether to search a 1-bit-per-pixel copy of the edges (word-level scans)
+static bool SUB_PIXEL = true; // Whether to refine the whisker matches to sub-pixel precision
+static int NUM_CANDIDATES = 1; // Edge candidates per whisker; more than 1 weights them softly in the solver
+static float COLOUR_WEIGHT = 0; // Weight (0-1) of the model colour in the pose solver, for planar models (0: edges only)
+static bool REGION_REFINEMENT = false; // Whether to pull planar models' outlines onto their colour regions after the edge solve
+static bool USE_THREADS = true; // Whether to share each model's whisker search and solve between all cores
+static bool USE_TEMPLATES = true; // Whether to find starting poses from the template banks (built once per model)
+static bool USE_LINE_INIT = true; // Whether to start planar models from the lines around them when no template matches
 
 
 
@@ -65,523 +90,206 @@ static bool USE_LINE_ITER = true; // Whether to use the line iterator technique
 int main(int argc, const char * argv[]) {
     
     // * * * * * * * * * * * * * * * * *
-    //   OPEN THE FIRST FRAME
+    //   LOAD THE SCENARIO
     // * * * * * * * * * * * * * * * * *
-    
-    Mat frame;
-    String filename = "C_Blue_6";
-    VideoCapture cap(dataFolder + filename + ".avi");
-    //VideoCapture cap(0); waitKey(1000);   // Uncomment this line to try live tracking
-    if(!cap.isOpened()) return -1;
-    
-    cap >> frame;
-    imshow("Frame", frame);
+    // The camera, the models and starting poses of each sequence, and where
+    // its video is, are in the scenario catalogue (see scenarios.yml)
+    String filename = "C_Blue_6";   // A scenario in the catalogue
+    if (argc > 1) filename = argv[1];
+    ScenarioCatalogue catalogue;
+    if (!catalogue.load(argc > 2 ? argv[2] : scenarioFile)) return -1;
+    if (catalogue.K.empty()) {
+        cout << "The scenario catalogue has no intrinsics (fx, fy, cx, cy)" << endl;
+        return -1;
+    }
+    const Scenario * scenario = catalogue.find(filename);
+    if (scenario == NULL) {
+        cout << "No scenario named " << filename << endl;
+        return -1;
+    }
+    Mat K = catalogue.K;
+    vector<const Model *> model = scenario->modelPointers();
+    vector<estimate> est = scenario->est;
     
     // * * * * * * * * * * * * * * * * *
-    //   MODEL CREATION
+    //   OPEN THE FIRST FRAME
     // * * * * * * * * * * * * * * * * *
     
-    Model * modelRect = new Rectangle(60, 80, Scalar(20, 65, 165));
-    Model * modelDog = new Dog(Scalar(19, 89, 64));
-    Model * modelArrow = new Arrow(Scalar(108, 79, 28));
-    Model * modelTriangle = new Triangle(Scalar(15, 0, 82));
-    Model * modelDiamond = new Diamond(Scalar(13, 134, 161));
-    Model * modelHouse = new House(Scalar(90, 90, 90));
-    Model * modelYellowBox = new Box(175, 210, 49, Scalar(0, 145, 206));    // Yellow box
-    Model * modelBrownBox = new Box(204, 257, 70, Scalar(141, 179, 231));     // Brown box
-    Model * modelBlueBox = new Box(300, 400, 75, Scalar(180, 95, 60));      // Blue foam box
-    Model * modelBrownCube = new Box(70, 70, 70, Scalar(35, 55, 90));       // Brown numbers cube
-
-    vector<Model *> model;
-    
-    // * * * * * * * * * * * * * * * * *
-    //   SELECT MODELS
-    // * * * * * * * * * * * * * * * * *
-    vector<estimate> est, prevEst;
-    if (filename == "Test") {
-        model = {modelBlueBox};
-    }
-    /*
-     2D TESTING VIDEOS
-     */
-    else if (filename == "NO_Arrow_1") {
-        model ={modelArrow};
-        //est = { estimate({-78,    8, 675, -0.83,  0.62,  0.14}, 0, 0) };
-    }
-    else if (filename == "NO_Arrow_2") {
-        model ={modelArrow};
-        //est = { estimate({-78,    8, 675, -0.83,  0.62,  0.14}, 0, 0) };
-    }
-    else if (filename == "NO_Arrow_3") {
-        model ={modelArrow};
-        //est = { estimate({-78,    8, 675, -0.83,  0.62,  0.14}, 0, 0) };
-    }
-    else if (filename == "NO_Arrow_4") {
-        model ={modelArrow};
-    }
-    else if (filename == "NO_Arrow_5") {
-        model ={modelArrow};
-    }
-    else if (filename == "NO_Arrow_6") {
-        model ={modelArrow};
-    }
-    else if (filename == "NO_Diamond_1") {
-        model ={modelDiamond};
-        //est = { estimate({-78,    8, 675, -0.83,  0.62,  0.14}, 0, 0) };
-    }
-    else if (filename == "NO_Diamond_2") {
-        model ={modelDiamond};
-        //est = { estimate({-78,    8, 675, -0.83,  0.62,  0.14}, 0, 0) };
-    }
-    else if (filename == "NO_Diamond_3") {
-        model ={modelDiamond};
-        //est = { estimate({-78,    8, 675, -0.83,  0.62,  0.14}, 0, 0) };
-    }
-    else if (filename == "NO_Dog_1") {
-        model ={modelDog};
-        //est = { estimate({-78,    8, 675, -0.83,  0.62,  0.14}, 0, 0) };
-    }
-    else if (filename == "NO_Dog_2") {
-        model ={modelDog};
-        //est = { estimate({-78,    8, 675, -0.83,  0.62,  0.14}, 0, 0) };
-    }
-    else if (filename == "NO_Dog_3") {
-        model ={modelDog};
-        //est = { estimate({-78,    8, 675, -0.83,  0.62,  0.14}, 0, 0) };
-    }
-    else if (filename == "NO_Rect_1") {
-        model ={modelRect};
-        //est = { estimate({-78,    8, 675, -0.83,  0.62,  0.14}, 0, 0) };
-    }
-    else if (filename == "NO_Rect_2") {
-        model ={modelRect};
-        //est = { estimate({-78,    8, 675, -0.83,  0.62,  0.14}, 0, 0) };
-    }
-    else if (filename == "NO_Rect_3") {
-        model ={modelRect};
-        //est = { estimate({-78,    8, 675, -0.83,  0.62,  0.14}, 0, 0) };
-    }
-    else if (filename == "2O_ArrowDog" || filename == "2O_O_ArrowDog") {
-        model = {modelArrow, modelDog};
-    }
-    else if (filename == "3O_ArrowDiamondDog_1") {
-        model = {modelArrow};
-        est = { estimate({-58,  -26, 420, -0.89,  0.00,  0.04}, 0, 0)
-                //estimate({-66,   74, 282, -0.93, -0.07, -0.01}, 0, 0)
-                //estimate({ 24,   48, 324, -0.93,  0.03,  0.04}, 0, 0)
-        };
-    }
-    else if (filename == "3O_ArrowDiamondDog_2" || filename == "3O_ArrowDiamondDog_3") {
-        model = {modelArrow};
-    }
-    else if (filename == "4O_ArrowDiamondDogRect_1" || filename == "4O_ArrowDiamondDogRect_2") {
-        model = {modelArrow, modelDiamond, modelDog, modelRect};
-    }
-    else if (filename == "C_Dog_1" || filename == "C_Dog_2" || filename == "O_Dog_1" || filename == "O_Dog_2" || filename == "O_Dog_3") {
-        model ={modelDog};
-    }
-    else if (filename == "C_Arrow_1" || filename == "C_Arrow_2" || filename == "O_Arrow_1") {
-        model ={modelArrow };
-    }
-    /*
-     3D TESTING VIDEOS
-     */
-    else if (filename == "NO_Blue_1") {
-        model ={modelBlueBox};
-        est = { estimate({-47,   -4, 756, -0.77,  0.55,  0.46}, 0, 0) };
-    }
-    else if (filename == "NO_Blue_2") {
-        model ={modelBlueBox};
-        est = { estimate({ 12,  -60, 723, -0.92, -0.70, -0.27}, 0, 0) };
-    }
-    else if (filename == "NO_Blue_3") {
-        model ={modelBlueBox};
-        est = { estimate({-59,  -42, 728, -0.79,  0.45,  0.20}, 0, 0) };
-    }
-    else if (filename == "NO_Brown_1") {
-        model ={modelBrownBox};
-        est = { estimate({-67,  -12, 745, -0.80,  0.49,  0.24}, 0, 0) };
-    }
-    else if (filename == "NO_Brown_2") {
-        model ={modelBrownBox};
-        est = { estimate({64,   -48, 730, -0.76,  0.71,  0.27}, 0, 0) };
-    }
-    else if (filename == "NO_Brown_3") {
-        model ={modelBrownBox};
-        est = { estimate({169,  -49, 740, -0.55, -0.12, -0.23}, 0, 0) };
-    }
-    else if (filename == "NO_Yellow_1") {
-        model ={modelYellowBox};
-        est = { estimate({-49,  -13, 738, -0.73,  0.48,  0.16}, 0, 0) };
-    }
-    else if (filename == "NO_Yellow_2") {
-        model ={modelYellowBox};
-        est = { estimate({ 95,  -73, 697, -0.28,  0.65,  0.51}, 0, 0) };
-    }
-    else if (filename == "NO_Yellow_3") {
-        model ={modelYellowBox};
-        est = { estimate({-170,  -63, 705, -0.61,  0.28,  0.06}, 0, 0) };
-    }
-    else if (filename == "C_Blue_1") {
-        model ={modelBlueBox};
-        est = { estimate({  28,  -70, 730, -0.73, -0.52, -0.30}, 0, 0) };
-    }
-    else if (filename == "C_Blue_2") {
-        model ={modelBlueBox};
-        est = { estimate({-33,  -45, 605, -0.85,  0.46,  0.20}, 0, 0) };
-    }
-    else if (filename == "C_Blue_3") {
-        model ={modelBlueBox};
-        est = { estimate({ -65,  -18, 603, -0.89, -0.63, -0.16}, 0, 0) };
-    }
-    else if (filename == "C_Blue_4") {
-        model ={modelBlueBox};
-        est = { estimate({-60,  -29, 675, -0.98,  0.40,  0.10}, 0, 0) };
-    }
-    else if (filename == "C_Blue_5") {
-        model ={modelBlueBox};
-        est = { estimate({-28,  -83, 694, -0.76, -0.54, -0.55}, 0, 0) };
-    }
-    else if (filename == "C_Blue_6") {
-        model ={modelBlueBox};
-        est = { estimate({-28,  -28, 640, -0.90,  0.05, -0.11}, 0, 0) };
-    }
-    else if (filename == "O_Blue_1") {
-        model ={modelBlueBox};
-        est = { estimate({-77,  -17, 700, -0.88,  0.55,  0.24}, 0, 0) };
-    }
-    else if (filename == "O_Blue_2") {
-        model ={modelBlueBox};
-        est = { estimate({-00,  -17, 700, -0.88,  0.30,  0.30}, 0, 0) };
-    }
-    else if (filename == "O_Blue_3") {
-        model ={modelBlueBox};
-        est = { estimate({-00,  -17, 700, -0.88, -0.20,  0.20}, 0, 0) };
-    }
-    else if (filename == "O_Blue_4") {
-        model ={modelBlueBox};
-        est = { estimate({-80,   20, 700, -0.88,  0.90,  0.50}, 0, 0) };
-    }
-    else if (filename == "Multi3D_1") {
-        model ={modelBlueBox, modelBrownBox, modelYellowBox};
-        est = { estimate({-175,   42, 830, -1.02, -0.44, -0.21}, 0, 0),
-                estimate({ 139, -132, 996,  0.45,  0.20,  0.11}, 0, 0),
-                estimate({ 271,  111, 789, -0.95,  0.63,  0.44}, 0, 0)
-        };
-    }
-    else if (filename == "Multi3D_2") {
-        model ={modelBlueBox, modelBrownBox, modelYellowBox};
-        est = { estimate({-245,   62, 846, -0.97, -0.66, -0.28}, 0, 0),
-                estimate({   0, -122, 996,  0.45,  0.00,  0.06}, 0, 0),
-                estimate({ 206,  110, 878, -1.05,  0.47,  0.35}, 0, 0)
-        };
-    }
-    else if (filename == "Multi3D_3") {
-        model ={modelBlueBox, modelBrownBox, modelYellowBox};
-        est = { estimate({  90,  -81, 958,  0.05, -0.46,  1.61}, 0, 0),
-                estimate({-186,  122, 773, -1.02, -0.43, -0.30}, 0, 0),
-                estimate({ 188,  157, 792, -0.85,  0.78,  0.57}, 0, 0)
-        };
-    }
-    /*
-        OTHER VIDEOS
-     */
-    else if (filename == "TrioHand_1") {
-        model ={modelRect, modelDog, modelArrow};
-        est = { estimate({ 95,  43, 360, -0.80,  0.25,  0.05}, 0, 0),
-                estimate({-77,  77, 311, -0.81,  0.11,  0.01}, 0, 0),
-                estimate({ 50, -21, 413, -0.77,  0.14,  0.05}, 0, 0) };
-    }
-    else if (filename == "TrioHand_2") {
-        model ={modelRect, modelDog, modelArrow};
-        est = { estimate({ 85,  28, 370,  0.16,  0.78,  1.65}, 0, 0),
-                estimate({-86,  60, 322, -0.83,  0.06, -0.08}, 0, 0),
-                estimate({ 28, -35, 430, -0.79,  0.05, -0.03}, 0, 0) };
-    }
-    else if (filename == "TrioHand_3") {
-        model ={modelRect, modelDog, modelArrow};
-        est = { estimate({-60,   0, 393, -0.78,  0.17, -0.02}, 0, 0),
-                estimate({ 18,  69, 328, -0.79,  0.11,  0.03}, 0, 0),
-                estimate({ 64, -26, 422, -0.77,  0.08,  0.00}, 0, 0) };
-    }
-    else if (filename == "TrioHand_4") {
-        model ={modelRect, modelDog, modelArrow};
-        est = { estimate({-44,  -6, 380, -0.85,  0.10,  0.05}, 0, 0),
-                estimate({ 18, -13, 413, -0.81,  0.11,  0.02}, 0, 0),
-                estimate({ 80,  27, 370, -0.76,  0.10,  0.04}, 0, 0) };
-    }
-    else if (filename == "RectDog_1") {
-        model ={modelRect, modelDog};
-        est = { estimate({  45,  10, 339, -0.82, -0.01,  0.00}, 0, 0),
-                estimate({ -92,  43, 299, -0.83, -0.04, -0.01}, 0, 0) };
-    }
-    else if (filename == "RectDog_2") {
-        model ={modelRect, modelDog};
-        est = { estimate({  18,  11, 336, -0.67,  0.54,  0.58}, 0, 0),
-                estimate({ -20,  -7, 352, -0.83, -0.03, -0.02}, 0, 0) };
-    }
-    else if (filename == "ArrowDiamond_1") {
-        model ={modelArrow, modelDiamond};
-        est = { estimate({  56,   6, 339, -0.64,  0.53,  0.53}, 0, 0),
-                estimate({ -77,  38, 294, -0.87, -0.07, -0.05}, 0, 0) };
-    }
-    else if (filename == "ArrowDiamond_2") {
-        model ={modelArrow, modelDiamond};
-        est = { estimate({  -7, -58, 400,  0.13,  0.82,  1.77}, 0, 0),
-                estimate({ -10, -10, 300, -2.30, -0.08,  0.02}, 0, 0) };
-    }
-    else if (filename == "ArrowDiamond_3") {
-        model ={modelArrow, modelDiamond};
-        est = { estimate({  14, -61, 411,  0.77, -2.79,  0.38}, 0, 0),
-                estimate({ -30,  41, 297, -0.86,  0.02,  0.04}, 0, 0) };
-    }
+    Mat frame;
+    string videoPath = catalogue.dataFolder + filename + ".avi";
+    string cachePath = FrameCache::pathFor(videoPath);
+    if (USE_FRAME_CACHE && !ifstream(cachePath).good()) FrameCache::build(videoPath, cachePath);
+    string uri = USE_FRAME_CACHE ? "cache:" + cachePath : videoPath;
+    if (LIVE_FPS > 0) uri = "live:paced:" + to_string(LIVE_FPS) + ":" + uri;
+    unique_ptr<FrameSource> source(FrameSource::open(uri));
+    //source.reset(FrameSource::open("live:camera:0")); waitKey(1000);   // Uncomment this line to try live tracking
+    if (!source) return -1;
     
-    else if (filename == "BlueYellow_1") {
-        model = {modelBlueBox,modelYellowBox};
-        est = { estimate({  41,  26,  800, -0.85,  0.82,  0.53}, 0, 0),
-                estimate({ -42, -38,  776, -0.98, -0.67, -0.40}, 0, 0) };
-    }
-    else if (filename == "BlueYellow_2") {
-        model = {modelBlueBox,modelYellowBox};
-        est = { estimate({ -30, -72,  879, -0.70,  0.39,  0.83}, 0, 0),
-                estimate({ 108, 105,  688, -0.25,  1.12,  1.27}, 0, 0) };
-    }
-    else if (filename == "BlueYellow_3") {
-        model = {modelBlueBox,modelYellowBox};
-        est = { estimate({  28,  71,  905,  0.34,  1.19,  1.84}, 0, 0),
-                estimate({  22,  46,  776, -1.14, -0.59, -0.30}, 0, 0) };
-    }
-    else if (filename == "BlueYellow_5") {
-        model = {modelBlueBox,modelYellowBox};
-        est = { estimate({ 140,  63,  824, -1.17, -0.32, -0.12}, 0, 0),
-                estimate({-195,  84,  802, -1.09, -0.68, -0.31}, 0, 0) };
-    }
-    else if (filename == "BlueYellow_7") {
-        model = {modelBlueBox,modelYellowBox};
-        est = { estimate({-147,   6,  779, -1.24, -0.84, -0.25}, 0, 0),
-                estimate({ 266,  15,  765, -1.35, -0.21, -0.04}, 0, 0) };
-    }
-    else if (filename == "BlueYellow_8") {
-        model = {modelBlueBox,modelYellowBox};
-        est = { estimate({  18, -95,  798, -0.71, -0.81, -0.31}, 0, 0),
-                estimate({-166,  56,  600, -1.27, -0.68, -0.19}, 0, 0) };
-    }
-    else if (filename == "BrownYellow_1") {
-        model = {modelBrownBox,modelYellowBox};
-        est = { estimate({ 25,  -17, 559, -0.73,  0.48,  0.60}, 0, 0),
-                estimate({ 25,  -75, 501, -0.70,  0.52,  0.60}, 0, 0) };
-    }
+    source->read(frame);
+    if (!HEADLESS) imshow("Frame", frame);
     
     // * * * * * * * * * * * * * * * * *
     //   LOCATE THE STARTING POSITIONS
     // * * * * * * * * * * * * * * * * *
-    //      Assume the objects are
-    //      leaning back at
-    //      ±45 degrees
-    // * * * * * * * * * * * * * * * * *
     
-    // If no initial poses are given, find them
-    if (est.size() == 0) {
-        // Find the initial pose of each model
+    Tracker tracker = Tracker(model, K, est);
+    ThreadPool pool;
+    if (USE_THREADS) tracker.pool = &pool;
+    tracker.useLineIter = USE_LINE_ITER;
+    tracker.useFusedEdges = USE_FUSED_EDGES;
+    tracker.useColourEdges = USE_COLOUR_EDGES;
+    tracker.useBitEdges = USE_BIT_EDGES;
+    tracker.subPixel = SUB_PIXEL;
+    tracker.numCandidates = NUM_CANDIDATES;
+    tracker.colourWeight = COLOUR_WEIGHT;
+    tracker.useRegion = REGION_REFINEMENT;
+    tracker.useLineInit = USE_LINE_INIT;
+    tracker.distortion = distortion;
+    tracker.traceWhiskers = DEBUGGING && !HEADLESS;
+    tracker.initialise(frame, USE_TEMPLATES ? catalogue.templateFolder : "");
+    est = tracker.getEstimates();
+    vector<string> initSources = tracker.getInitSources();
+    for (int m = 0; m < initSources.size(); m++) cout << "Starting pose of " << model[m]->name << ": " << initSources[m] << endl;
+    
+    if (!HEADLESS) {
+        Mat frame2;
+        frame.copyTo(frame2);
         for (int m = 0; m < model.size(); m++) {
-            
-            // Find the area & centoid of the object in the image
-            Mat segInit = orange::segmentByColour(frame, model[m]->colour);
-            cvtColor(segInit, segInit, CV_BGR2GRAY);
-            threshold(segInit, segInit, 0, 255, CV_THRESH_BINARY);
-            Point centroid = ASM::getCentroid(segInit);
-            double area = ASM::getArea(segInit);
-            
-            // Draw the model at the default position and find the area & cetroid
-            Vec6f initPose = {0, 0, 300, -CV_PI/4, 0, 0};
-            Mat initGuess = Mat::zeros(frame.rows, frame.cols, frame.type());
-            model[m]->draw(initGuess, initPose, K, false);
-            cvtColor(initGuess, initGuess, CV_BGR2GRAY);
-            threshold(initGuess, initGuess, 0, 255, CV_THRESH_BINARY);
-            Point modelCentroid = ASM::getCentroid(initGuess);
-            double modelArea = ASM::getArea(initGuess);
-            
-            // Convert centroids to 3D/homogeneous coordinates
-            Mat centroid2D;
-            hconcat( Mat(centroid), Mat(modelCentroid), centroid2D );
-            vconcat(centroid2D, Mat::ones(1, 2, centroid2D.type()), centroid2D);
-            centroid2D.convertTo(centroid2D, K.type());
-            Mat centroid3D = K.inv() * centroid2D;
-            
-            // Estimate the depth from the ratio of the model and measured areas,
-            // and create a pose guess from that.
-            // Note that the x & y coordinates need to be calculated using the pose
-            // of the centroid relative to the synthetic model image's centroid.
-            double zGuess = initPose[2] * sqrt(modelArea/area);
-            centroid3D *= zGuess;
-            initPose[0] = centroid3D.at<float>(0, 0) - centroid3D.at<float>(0, 1);
-            initPose[1] = centroid3D.at<float>(1, 0) - centroid3D.at<float>(1, 1);
-            initPose[2] = zGuess;
-            
-            // Set the intial pose
-            estimate initEst = estimate(initPose, 0, 0);
-            
-            // Add the estimate to the list
-            est.push_back(initEst);
+            model[m]->draw(frame2, est[m].pose, K, true, model[m]->colour);
         }
+        imshow("Frame", frame2);
+        
+        // Uncomment to allow annotation
+        //addMouseHandler("Frame");
     }
     
-    Mat frame2;
-    frame.copyTo(frame2);
-    for (int m = 0; m < model.size(); m++) {
-        model[m]->draw(frame2, est[m].pose, K, true, model[m]->colour);
-    }
-    imshow("Frame", frame2);
-    prevEst = est;
+    // * * * * * * * * * * * * * * * * *
+    //   SET UP LOGGER
+    // * * * * * * * * * * * * * * * * *
+    // Convert the log to CSV afterwards with the LogConverter target
+    PoseLogger logger;
+    if (LOGGING) logger.open(logFolder + filename + ".etlog", (int)model.size());
     
-    // Uncomment to allow annotation
-    //addMouseHandler("Frame");
+    // Other processes can follow the poses live through shared memory (see telemetry.hpp)
+    TelemetryPublisher publisher;
+    if (PUBLISHING && !publisher.open()) cout << "Could not publish to " << TelemetryPublisher::DEFAULT_NAME << endl;
     
     // * * * * * * * * * * * * * * * * *
-    //   SET UP LOGGER
+    //   SET UP DISPLAY
     // * * * * * * * * * * * * * * * * *
-    ofstream log;
-    if (LOGGING) {
-        log.open(logFolder + filename + ".csv");
-        log << "Time";
-        for (int m = 0; m < model.size(); m++) log << ";error_Area_ " << m << ";error_LSQ_ " << m << ";tX_ " << m << ";tY_ " << m << ";tZ_ " << m << ";rX_ " << m << ";rY_ " << m << ";rZ_ " << m;
-        log << endl;
-    }
+    // The display draws on the main thread while the tracking runs on its own,
+    // so tracking never waits for drawing (see display.hpp)
+    Display display = Display(model, K, !HEADLESS);
+    if (SAVE_VIDEO) display.openVideo(logFolder + filename + "_annotated.avi", frame.size());
     
-    waitKey(0);
+    if (!HEADLESS) waitKey(0);
     
     // * * * * * * * * * * * * * * * * *
     //   CAMERA LOOP
     // * * * * * * * * * * * * * * * * *
     
     vector<double> times = {};
+    vector<double> latencies = {};  // Capture to pose (live sources only)
     double longestTime = 0.0;
     vector<vector<double>> errorArea = vector<vector<double>>(model.size());
     vector<double> errorAreaWorst = vector<double>(model.size());
     
-    while (!frame.empty()) {
-        
-        // Keep original image (for area check)
-        Mat frameOrig;
-        frame.copyTo(frameOrig);
-        
-        auto start = chrono::system_clock::now();   // Start the timer
-        
-        // Blur
-        GaussianBlur(frame, frame, Size(3,3), 1);
-        
-        // Detect edges
-        Mat canny, canny2, cannyTest;
-        Canny(frame, canny, 20, 60);
-        canny.copyTo(canny2);
-        cvtColor(canny2, canny2, CV_GRAY2BGR);
-        
-        // Extract the image edge point coordinates
-        Mat edges;
-        if (!USE_LINE_ITER) findNonZero(canny, edges);
-        else dilate(canny, canny, getStructuringElement(CV_SHAPE_CROSS, Size(3,3)));
-        
-        // Find the pose of each model
-        for (int m = 0; m < model.size(); m++) {
-            // Predict the next pose
-            Vec6f poseVelocity = est[m].pose - prevEst[m].pose;
-            poseVelocity = estimate::standardisePose(poseVelocity);
-            Vec6f posePrediction = est[m].pose + 0.5 * poseVelocity;
-            prevEst[m] = est[m];
-            est[m].pose = posePrediction;
+    BufferPool framePool;
+    FrameBudget budget = FrameBudget(FRAME_BUDGET);
+    thread trackingThread([&] {
+        while (!frame.empty() && !display.quitRequested()) {
             
-            int iterations = 1;
-            double error = lsq::ERROR_THRESHOLD + 1;
-            while (error > lsq::ERROR_THRESHOLD && iterations < 20) {
-                // Generate a set of whiskers
-                vector<Whisker> whiskers = ASM::projectToWhiskers(model[m], est[m].pose, K);
-                
-                canny2.copyTo(cannyTest);
-                
-                // Sample along the model edges and find the edges that intersect each whisker
-                Mat targetPoints = Mat(2, 0, CV_32S);
-                Mat whiskerModel = Mat(4, 0, CV_32FC1);
-                for (int w = 0; w < whiskers.size(); w++) {
-                    Point closestEdge;
-                    if (!USE_LINE_ITER) closestEdge = whiskers[w].closestEdgePoint(edges);
-                    else closestEdge = whiskers[w].closestEdgePoint2(canny);
-                    if (closestEdge == Point(-1,-1)) continue;
-                    hconcat(whiskerModel, whiskers[w].modelCentre, whiskerModel);
-                    hconcat(targetPoints, Mat(closestEdge), targetPoints);
-                    
-                    //TRACE: Display the whiskers
-                    line(cannyTest, closestEdge, whiskers[w].centre, Scalar(255,150,0), 2);
-                    circle(cannyTest, closestEdge, 3, Scalar(0,255,0), -1);
-                    circle(cannyTest, whiskers[w].centre, 3, Scalar(0,0,255), -1);
-                    
-                    //Point endPos = whiskers[w].centre + Point(40*whiskers[w].normal.x, 40*whiskers[w].normal.y);
-                    //Point endNeg = whiskers[w].centre - Point(40*whiskers[w].normal.x, 40*whiskers[w].normal.y);
-                    //line(cannyTest, endPos, endNeg, Scalar(200));
-                }
-                
-                targetPoints.convertTo(targetPoints, CV_32FC1);
-                
-                // Catch error where no points are found
-                if (whiskerModel.cols == 0) break;
-                
-                // Use least squares to match the sampled edges to each other
-                est[m] = lsq::poseEstimateLM(est[m].pose, whiskerModel, targetPoints.t(), K, 2);
-                
-                
-                double improvement = (error - est[m].error)/error;
-                error = est[m].error;
-                
-                // Stop trying if you reduce the error by < 1% (excl. the first one)
-                if (improvement < 0.01 && iterations > 1) break;
-                
-                iterations++;
-                //imshow("CannyTest", cannyTest); waitKey(0);
+            // Wait while paused from the display
+            while (display.paused() && !display.quitRequested()) this_thread::sleep_for(chrono::milliseconds(10));
+            
+            auto start = chrono::system_clock::now();   // Start the timer
+            
+            // Scale the tracking to the frame budget, if there is one
+            auto frameStart = chrono::steady_clock::now();
+            if (FRAME_BUDGET > 0) budget.apply(tracker, frameStart);
+            bool reportErrors = REPORT_ERRORS && (FRAME_BUDGET <= 0 || budget.allowErrors());
+            
+            // Find the pose of each model
+            tracker.processFrame(frame);
+            est = tracker.getEstimates();
+            
+            // Stop timer and show time
+            auto stop = chrono::system_clock::now();
+            chrono::duration<double> frameTime = stop-start;
+            double time = frameTime.count()*1000.0;
+            times.push_back(time);
+            if (time > longestTime) longestTime = time;
+            double latency = NAN;
+            if (source->getCaptureTime() != chrono::steady_clock::time_point()) {
+                chrono::duration<double, milli> sinceCapture = chrono::steady_clock::now() - source->getCaptureTime();
+                latency = sinceCapture.count();
+                latencies.push_back(latency);
             }
-        }
-        
-        // Draw the shapes on the image
-        for (int m = 0; m < model.size(); m++) {
-            model[m]->draw(frame, est[m].pose, K, true);
-        }
-        imshow("Frame", frame);
-        
-        // Stop timer and show time
-        auto stop = chrono::system_clock::now();
-        chrono::duration<double> frameTime = stop-start;
-        double time = frameTime.count()*1000.0;
-        times.push_back(time);
-        if (time > longestTime) longestTime = time;
-        
-        // Measure and report the area errors
-        for (int m = 0; m < model.size(); m++) {
-            if (REPORT_ERRORS) {
-                Mat seg = orange::segmentByColour(frameOrig, model[m]->colour);
-                if (DEBUGGING) imshow("seg " + to_string(m), seg);
-                double areaError = area::areaError(est[m].pose, model[m], seg, K);
-                errorArea[m].push_back(areaError);
-                if (areaError > errorAreaWorst[m]) errorAreaWorst[m] = areaError;
+            
+            // Hand the results to the display (the frame is shared, not copied)
+            if (display.active()) {
+                Snapshot snapshot;
+                snapshot.frameNo = (int)times.size() - 1;
+                snapshot.frame = frame;
+                snapshot.est = est;
+                snapshot.whiskers = tracker.getWhiskerTrace();
+                snapshot.time = time;
+                display.submit(snapshot);
             }
-        }
-        
-        // Log time and errors
-        if (LOGGING) {
-            log << time;
+            
+            // Measure and report the area errors
+            auto errorStart = chrono::steady_clock::now();
             for (int m = 0; m < model.size(); m++) {
-                log << ";" << errorArea[m].back() << ";" << est[m].error;
-                for (int i = 0; i < 6; i++) log << ";" << est[m].pose[i];
+                if (reportErrors) {
+                    Mat seg;
+                    {
+                        PROFILE_SCOPE(STAGE_SEGMENT);
+                        seg = orange::segmentByColour(frame, model[m]->colour);
+                    }
+                    if (DEBUGGING) display.show("seg " + to_string(m), seg);
+                    double areaError;
+                    {
+                        PROFILE_SCOPE(STAGE_AREA_ERROR);
+                        if (POLYGON_AREA && !model[m]->is3D) areaError = area::areaError(est[m].pose, model[m], area::outline(seg), K);
+                        else areaError = area::areaError(est[m].pose, model[m], seg, K);
+                    }
+                    errorArea[m].push_back(areaError);
+                    if (areaError > errorAreaWorst[m]) errorAreaWorst[m] = areaError;
+                }
+            }
+            chrono::duration<double, milli> errorTime = chrono::steady_clock::now() - errorStart;
+            
+            // Log time and errors
+            if (LOGGING) {
+                for (int m = 0; m < model.size(); m++) {
+                    logger.log((int)times.size() - 1, m, time, reportErrors ? errorArea[m].back() : NAN, est[m]);
+                }
             }
-            log << endl;
+            if (PUBLISHING) {
+                for (int m = 0; m < model.size(); m++) {
+                    publisher.publish((int)times.size() - 1, m, est[m], reportErrors ? errorArea[m].back() : NAN, time, tracker.getStats(), latency);
+                }
+            }
+            
+            if (DEBUGGING && !HEADLESS) display.show("CannyTest", tracker.getEdges().clone());
+            
+            // Learn the costs of this frame (excluding the wait for the next one)
+            if (FRAME_BUDGET > 0) {
+                chrono::duration<double, milli> wholeFrame = chrono::steady_clock::now() - frameStart;
+                budget.record(tracker.getStats(), wholeFrame.count(), reportErrors ? errorTime.count() : 0);
+            }
+            
+            // Get next frame, into a buffer the display is not still using
+            Size size = frame.size();
+            frame = framePool.acquire(size, CV_8UC3);
+            if (!source->read(frame)) frame = Mat();
         }
-        
-        if (DEBUGGING) imshow("CannyTest", cannyTest);
-        
-        // Get next frame
-        cap >> frame;
-        
-        int key = waitKey(0);
-        if (key == 'q') break;
-        else if (key == 'p') waitKey(0);
-    }
+        display.finish();
+    });
+    
+    if (display.active()) display.run();
+    trackingThread.join();
+    if (display.getDropped() > 0) cout << "Display skipped " << display.getDropped() << " frames" << endl << endl;
     
     vector<double> meanTime, stdDevTime;
     meanStdDev(times, meanTime, stdDevTime);
@@ -591,10 +299,24 @@ int main(int argc, const char * argv[]) {
     cout << "stdDev time  = " << stdDevTime[0] << " ms" << endl;
     cout << "Longest time = " << longestTime << " ms     " << 1000.0/longestTime << " fps" << endl;
     
+    if (!latencies.empty()) {
+        vector<double> meanLatency, stdDevLatency;
+        meanStdDev(latencies, meanLatency, stdDevLatency);
+        cout << "Avg latency  = " << meanLatency[0] << " ms     (capture to pose)" << endl;
+        cout << "stdDev lat.  = " << stdDevLatency[0] << " ms" << endl;
+        cout << "Dropped      = " << source->getDropped() << " frames" << endl;
+    }
+    
+    if (FRAME_BUDGET > 0) {
+        cout << endl;
+        budget.report();
+    }
+    
     // Report errors
     if (REPORT_ERRORS) {
         cout << endl << "AREA ERRORS:" << endl << "Model   Mean     StDev    Worst" << endl;
         for (int m = 0; m < model.size(); m++) {
+            if (errorArea[m].empty()) continue;     // Every pass skipped for the frame budget
             vector<double> meanError, stdDevError;
             meanStdDev(errorArea[m], meanError, stdDevError);
             printf("%4i    %5.2f    %5.2f    %5.2f \n", m, meanError[0], stdDevError[0], errorAreaWorst[m]);
@@ -602,7 +324,14 @@ int main(int argc, const char * argv[]) {
         }
     }
     
-    if (LOGGING) log.close();
+    if (LOGGING) logger.close();
+    if (PUBLISHING) publisher.close();
+    
+#ifdef PROFILING
+    cout << endl;
+    Profiler::report();
+    Profiler::writeTrace(logFolder + filename + "_trace.json");
+#endif
     
     return 0;
 }
@@ -6,6 +6,8 @@
 //  Copyright © 2018 Daniel Mesham. All rights reserved.
 //
 
+#include <map>
+
 #include "lsq.hpp"
 #include "models.hpp"
 
@@ -14,7 +16,7 @@
 //      Model
 // * * * * * * * * * * * * * * *
 
-Mat Model::pointsToMat() {
+Mat Model::pointsToMat() const {
     Mat ret = Mat(4, int(vertices.size()), CV_32FC1);
     for (int i = 0; i < vertices.size(); i++) {
         Point3f p = vertices[i];
@@ -26,6 +28,35 @@ Mat Model::pointsToMat() {
     return ret * 1;
 }
 
+shared_ptr<const Model> Model::byName(string name) {
+    // Returns the shared (immutable) instance of one of the known models,
+    // or null if the name is not recognised
+    static const map<string, shared_ptr<const Model>> library = [] {
+        map<string, shared_ptr<Model>> models = {
+            {"Rect",      make_shared<Rectangle>(60, 80, Scalar(20, 65, 165))},
+            {"Dog",       make_shared<Dog>(Scalar(19, 89, 64))},
+            {"Arrow",     make_shared<Arrow>(Scalar(108, 79, 28))},
+            {"Triangle",  make_shared<Triangle>(Scalar(15, 0, 82))},
+            {"Diamond",   make_shared<Diamond>(Scalar(13, 134, 161))},
+            {"House",     make_shared<House>(Scalar(90, 90, 90))},
+            {"YellowBox", make_shared<Box>(175, 210, 49, Scalar(0, 145, 206))},    // Yellow box
+            {"BrownBox",  make_shared<Box>(204, 257, 70, Scalar(141, 179, 231))},  // Brown box
+            {"BlueBox",   make_shared<Box>(300, 400, 75, Scalar(180, 95, 60))},    // Blue foam box
+            {"BrownCube", make_shared<Box>(70, 70, 70, Scalar(35, 55, 90))}        // Brown numbers cube
+        };
+        map<string, shared_ptr<const Model>> ret;
+        for (auto & m : models) {
+            m.second->name = m.first;
+            ret[m.first] = m.second;
+        }
+        return ret;
+    }();
+    
+    auto it = library.find(name);
+    if (it == library.end()) return nullptr;
+    return it->second;
+}
+
 
 // * * * * * * * * * * * * * * *
 //      Box
@@ -49,7 +80,7 @@ const vector<vector<int>> Box::faces = {
     {4,5,6,7}, {1,2,6,5}, {2,3,7,6}
 };
 
-bool Box::vertexIsVisible(int vertexID, float xAngle, float yAngle) {
+bool Box::vertexIsVisible(int vertexID, float xAngle, float yAngle) const {
     while (yAngle < 0)          yAngle += 2*CV_PI;
     while (yAngle >= 2*CV_PI)   yAngle -= 2*CV_PI;
     if (yAngle > 0.5*CV_PI && yAngle < 1.5*CV_PI) {
@@ -71,7 +102,7 @@ bool Box::vertexIsVisible(int vertexID, float xAngle, float yAngle) {
     return true;
 }
 
-vector<bool> Box::faceVisibilityMask(Vec6f pose) {
+vector<bool> Box::faceVisibilityMask(Vec6f pose) const {
     vector<bool> ret(6);
     
     // Find normals after rotation
@@ -107,7 +138,7 @@ vector<bool> Box::faceVisibilityMask(Vec6f pose) {
     return ret;
 }
 
-vector<bool> Box::visibilityMask(float xAngle, float yAngle) {
+vector<bool> Box::visibilityMask(float xAngle, float yAngle) const {
     vector<bool> mask;
     for (int i = 0; i < 8; i++) {
         mask.push_back(vertexIsVisible(i, xAngle, yAngle));
@@ -115,7 +146,7 @@ vector<bool> Box::visibilityMask(float xAngle, float yAngle) {
     return mask;
 }
 
-vector<bool> Box::visibilityMask(Vec6f pose) {
+vector<bool> Box::visibilityMask(Vec6f pose) const {
     vector<bool> mask(8);
     vector<bool> maskFaces = faceVisibilityMask(pose);
     for (int f = 0; f < 6; f++) {
@@ -152,7 +183,7 @@ void Box::createPoints(float w, float h, float d) {
     normMag = Mat(1, 6, CV_32F, normMagArr) * 1;
 }
 
-void Box::draw(Mat img, Vec6f pose, Mat K, bool lines, Scalar colour) {
+void Box::draw(Mat img, Vec6f pose, Mat K, bool lines, Scalar colour) const {
     Mat proj = lsq::projection(pose, pointsToMat(), K);
     
     // Create a list of points
@@ -186,11 +217,11 @@ void Box::draw(Mat img, Vec6f pose, Mat K, bool lines, Scalar colour) {
 //      Rectangle
 // * * * * * * * * * * * * * * *
 
-bool Rectangle::vertexIsVisible(int vertexID, float xAngle, float yAngle) {
+bool Rectangle::vertexIsVisible(int vertexID, float xAngle, float yAngle) const {
     return true;
 }
 
-vector<bool> Rectangle::visibilityMask(float xAngle, float yAngle) {
+vector<bool> Rectangle::visibilityMask(float xAngle, float yAngle) const {
     return {true, true, true, true};
 }
 
@@ -204,7 +235,7 @@ void Rectangle::createPoints(float w, float h) {
     vertices = {p0, p1, p2, p3};
 }
 
-void Rectangle::draw(Mat img, Vec6f pose, Mat K, bool lines, Scalar colour) {
+void Rectangle::draw(Mat img, Vec6f pose, Mat K, bool lines, Scalar colour) const {
     Mat proj = lsq::projection(pose, pointsToMat(), K);
     
     // Create a list of points
@@ -246,11 +277,11 @@ Dog::Dog(Scalar colourIn) {
     is3D = false;
 };
 
-vector<bool> Dog::visibilityMask(float xAngle, float yAngle) {
+vector<bool> Dog::visibilityMask(float xAngle, float yAngle) const {
     return {true, true, true, true, true, true, true, true, true, true, true, true, true, true, true};
 }
 
-void Dog::draw(Mat img, Vec6f pose, Mat K, bool lines, Scalar colour) {
+void Dog::draw(Mat img, Vec6f pose, Mat K, bool lines, Scalar colour) const {
     Mat proj = lsq::projection(pose, pointsToMat(), K);
     
     // Create a list of points
@@ -291,11 +322,11 @@ Arrow::Arrow(Scalar colourIn) {
     is3D = false;
 };
 
-vector<bool> Arrow::visibilityMask(float xAngle, float yAngle) {
+vector<bool> Arrow::visibilityMask(float xAngle, float yAngle) const {
     return {true, true, true, true, true, true, true};
 }
 
-void Arrow::draw(Mat img, Vec6f pose, Mat K, bool lines, Scalar colour) {
+void Arrow::draw(Mat img, Vec6f pose, Mat K, bool lines, Scalar colour) const {
     Mat proj = lsq::projection(pose, pointsToMat(), K);
     
     // Create a list of points
@@ -334,11 +365,11 @@ Triangle::Triangle(Scalar colourIn) {
     is3D = false;
 };
 
-vector<bool> Triangle::visibilityMask(float xAngle, float yAngle) {
+vector<bool> Triangle::visibilityMask(float xAngle, float yAngle) const {
     return {true, true, true};
 }
 
-void Triangle::draw(Mat img, Vec6f pose, Mat K, bool lines, Scalar colour) {
+void Triangle::draw(Mat img, Vec6f pose, Mat K, bool lines, Scalar colour) const {
     Mat proj = lsq::projection(pose, pointsToMat(), K);
     
     // Create a list of points
@@ -378,11 +409,11 @@ Diamond::Diamond(Scalar colourIn) {
     is3D = false;
 };
 
-vector<bool> Diamond::visibilityMask(float xAngle, float yAngle) {
+vector<bool> Diamond::visibilityMask(float xAngle, float yAngle) const {
     return {true, true, true, true, true};
 }
 
-void Diamond::draw(Mat img, Vec6f pose, Mat K, bool lines, Scalar colour) {
+void Diamond::draw(Mat img, Vec6f pose, Mat K, bool lines, Scalar colour) const {
     Mat proj = lsq::projection(pose, pointsToMat(), K);
     
     // Create a list of points
@@ -422,11 +453,11 @@ House::House(Scalar colourIn) {
     is3D = false;
 };
 
-vector<bool> House::visibilityMask(float xAngle, float yAngle) {
+vector<bool> House::visibilityMask(float xAngle, float yAngle) const {
     return {true, true, true, true, true, true, true};
 }
 
-void House::draw(Mat img, Vec6f pose, Mat K, bool lines, Scalar colour) {
+void House::draw(Mat img, Vec6f pose, Mat K, bool lines, Scalar colour) const {
     Mat proj = lsq::projection(pose, pointsToMat(), K);
     
     // Create a list of points
@@ -10,6 +10,7 @@
 #define models_hpp
 
 #include <opencv2/core/core.hpp>
+#include <memory>
 #include <stdio.h>
 #include "lsq.hpp"
 
@@ -23,14 +24,17 @@ using namespace cv;
 
 class Model {
 public:
-    bool vertexIsVisible(int vertexID, float xAngle, float yAngle);
-    virtual vector<bool> visibilityMask(float xAngle, float yAngle) = 0;
-    virtual vector<bool> visibilityMask(Vec6f pose) = 0;
-    vector<Point3f> getVertices() {return vertices;};
-    vector<vector<int>> getEdgeBasisList() {return edgeBasisList;}
-    Mat pointsToMat();
-    virtual void draw(Mat img, Vec6f pose, Mat K, bool lines = true, Scalar colour = Scalar(255, 255, 255)) = 0;
+    virtual ~Model() {}
+    bool vertexIsVisible(int vertexID, float xAngle, float yAngle) const;
+    virtual vector<bool> visibilityMask(float xAngle, float yAngle) const = 0;
+    virtual vector<bool> visibilityMask(Vec6f pose) const = 0;
+    vector<Point3f> getVertices() const {return vertices;};
+    vector<vector<int>> getEdgeBasisList() const {return edgeBasisList;}
+    Mat pointsToMat() const;
+    virtual void draw(Mat img, Vec6f pose, Mat K, bool lines = true, Scalar colour = Scalar(255, 255, 255)) const = 0;
+    static shared_ptr<const Model> byName(string name);
     Scalar colour = Scalar(255, 255, 255);
+    string name = "";
     bool is3D;
     
 protected:
@@ -60,11 +64,11 @@ public:
         colour = colourIn;
         is3D = true;
     }
-    bool vertexIsVisible(int vertexID, float xAngle, float yAngle);
-    vector<bool> visibilityMask(float xAngle, float yAngle);
-    vector<bool> visibilityMask(Vec6f pose);
-    vector<bool> faceVisibilityMask(Vec6f pose);
-    void draw(Mat img, Vec6f pose, Mat K, bool lines, Scalar colour);
+    bool vertexIsVisible(int vertexID, float xAngle, float yAngle) const;
+    vector<bool> visibilityMask(float xAngle, float yAngle) const;
+    vector<bool> visibilityMask(Vec6f pose) const;
+    vector<bool> faceVisibilityMask(Vec6f pose) const;
+    void draw(Mat img, Vec6f pose, Mat K, bool lines, Scalar colour) const;
     
 private:
     static const vector<vector<float>> xAngleLimits;
@@ -90,10 +94,10 @@ public:
         colour = colourIn;
         is3D = false;
     }
-    bool vertexIsVisible(int vertexID, float xAngle, float yAngle);
-    vector<bool> visibilityMask(float xAngle, float yAngle);
-    vector<bool> visibilityMask(Vec6f pose) {return visibilityMask(pose[3], pose[4]);};
-    void draw(Mat img, Vec6f pose, Mat K, bool lines, Scalar colour);
+    bool vertexIsVisible(int vertexID, float xAngle, float yAngle) const;
+    vector<bool> visibilityMask(float xAngle, float yAngle) const;
+    vector<bool> visibilityMask(Vec6f pose) const {return visibilityMask(pose[3], pose[4]);};
+    void draw(Mat img, Vec6f pose, Mat K, bool lines, Scalar colour) const;
     
 private:
     void createPoints(float width, float height);
@@ -107,10 +111,10 @@ private:
 class Dog : public Model {
 public:
     Dog(Scalar colourIn);
-    bool vertexIsVisible(int vertexID, float xAngle, float yAngle) {return true;};
-    vector<bool> visibilityMask(float xAngle, float yAngle);
-    vector<bool> visibilityMask(Vec6f pose) {return visibilityMask(pose[3], pose[4]);};
-    void draw(Mat img, Vec6f pose, Mat K, bool lines, Scalar colour);
+    bool vertexIsVisible(int vertexID, float xAngle, float yAngle) const {return true;};
+    vector<bool> visibilityMask(float xAngle, float yAngle) const;
+    vector<bool> visibilityMask(Vec6f pose) const {return visibilityMask(pose[3], pose[4]);};
+    void draw(Mat img, Vec6f pose, Mat K, bool lines, Scalar colour) const;
 };
 
 
@@ -121,10 +125,10 @@ public:
 class Arrow : public Model {
 public:
     Arrow(Scalar colourIn);
-    bool vertexIsVisible(int vertexID, float xAngle, float yAngle) {return true;};
-    vector<bool> visibilityMask(float xAngle, float yAngle);
-    vector<bool> visibilityMask(Vec6f pose) {return visibilityMask(pose[3], pose[4]);};
-    void draw(Mat img, Vec6f pose, Mat K, bool lines, Scalar colour);
+    bool vertexIsVisible(int vertexID, float xAngle, float yAngle) const {return true;};
+    vector<bool> visibilityMask(float xAngle, float yAngle) const;
+    vector<bool> visibilityMask(Vec6f pose) const {return visibilityMask(pose[3], pose[4]);};
+    void draw(Mat img, Vec6f pose, Mat K, bool lines, Scalar colour) const;
 };
 
 // * * * * * * * * * * * * * * *
@@ -134,10 +138,10 @@ public:
 class Triangle : public Model {
 public:
     Triangle(Scalar colourIn);
-    bool vertexIsVisible(int vertexID, float xAngle, float yAngle) {return true;};
-    vector<bool> visibilityMask(float xAngle, float yAngle);
-    vector<bool> visibilityMask(Vec6f pose) {return visibilityMask(pose[3], pose[4]);};
-    void draw(Mat img, Vec6f pose, Mat K, bool lines, Scalar colour);
+    bool vertexIsVisible(int vertexID, float xAngle, float yAngle) const {return true;};
+    vector<bool> visibilityMask(float xAngle, float yAngle) const;
+    vector<bool> visibilityMask(Vec6f pose) const {return visibilityMask(pose[3], pose[4]);};
+    void draw(Mat img, Vec6f pose, Mat K, bool lines, Scalar colour) const;
 };
 
 // * * * * * * * * * * * * * * *
@@ -147,10 +151,10 @@ public:
 class Diamond : public Model {
 public:
     Diamond(Scalar colourIn);
-    bool vertexIsVisible(int vertexID, float xAngle, float yAngle) {return true;};
-    vector<bool> visibilityMask(float xAngle, float yAngle);
-    vector<bool> visibilityMask(Vec6f pose) {return visibilityMask(pose[3], pose[4]);};
-    void draw(Mat img, Vec6f pose, Mat K, bool lines, Scalar colour);
+    bool vertexIsVisible(int vertexID, float xAngle, float yAngle) const {return true;};
+    vector<bool> visibilityMask(float xAngle, float yAngle) const;
+    vector<bool> visibilityMask(Vec6f pose) const {return visibilityMask(pose[3], pose[4]);};
+    void draw(Mat img, Vec6f pose, Mat K, bool lines, Scalar colour) const;
 };
 
 // * * * * * * * * * * * * * * *
@@ -160,10 +164,10 @@ public:
 class House : public Model {
 public:
     House(Scalar colourIn);
-    bool vertexIsVisible(int vertexID, float xAngle, float yAngle) {return true;};
-    vector<bool> visibilityMask(float xAngle, float yAngle);
-    vector<bool> visibilityMask(Vec6f pose) {return visibilityMask(pose[3], pose[4]);};
-    void draw(Mat img, Vec6f pose, Mat K, bool lines, Scalar colour);
+    bool vertexIsVisible(int vertexID, float xAngle, float yAngle) const {return true;};
+    vector<bool> visibilityMask(float xAngle, float yAngle) const;
+    vector<bool> visibilityMask(Vec6f pose) const {return visibilityMask(pose[3], pose[4]);};
+    void draw(Mat img, Vec6f pose, Mat K, bool lines, Scalar colour) const;
 };
 
 
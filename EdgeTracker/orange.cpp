@@ -10,19 +10,20 @@
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 #include <iostream>
+#include "hough.hpp"
 #include "orange.hpp"
 
 using namespace std;
 using namespace cv;
 
 
-vector<Vec4i> orange::borderLines(Mat img) {
-    // Returns the lines corresponding to the edges of the rectangle from an image.
+vector<Vec4i> orange::borderLines(Mat img, int numLines) {
+    // Returns the lines corresponding to the edges of the rectangle from an image:
+    // the numLines strongest, from a single Hough transform.
     
     // Resolutions of the rho and theta parameters of the lines
     double res_rho = 5;
     double res_theta = CV_PI/180;
-    int threshold = 60;
     double minLineLength = 50;
     double maxLineGap = 30;
     
@@ -30,14 +31,9 @@ vector<Vec4i> orange::borderLines(Mat img) {
     Mat dst;
     Canny(img, dst, 70, 210, 3, true);
     
-    // Line detection
-    vector<Vec4i> lines;
-    while ((lines.size() < 4) && (threshold > 0)) {
-        HoughLinesP(dst, lines, res_rho, res_theta, threshold, minLineLength, maxLineGap);
-        threshold -= 5;
-    }
-    
-    return lines;
+    // Line detection, reusing the accumulator from call to call
+    static thread_local ProgressiveHough hough(res_rho, res_theta);
+    return hough.find(dst, numLines, ProgressiveHough::MIN_VOTES, minLineLength, maxLineGap);
 }
 
 
@@ -84,3 +80,36 @@ Mat orange::segmentByColour(Mat img, Scalar colour) {
     
     return imgResult;
 }
+
+
+void orange::hueDistance(Mat img, Scalar colour, Mat & dist, Mat & gradX, Mat & gradY, double sigma) {
+    // How far each pixel's hue is from the given colour's, for region-based pose terms.
+    // dist: hue distance (0-90, CV_32FC1), smoothed so that it falls off gradually
+    //       towards the object; grey or dark pixels count as the furthest
+    // gradX, gradY: its image gradients (per pixel)
+    
+    // Convert colour to HSV
+    Mat bgr(1 ,1 , CV_8UC3, colour);
+    Mat3b hsv;
+    cvtColor(bgr, hsv, COLOR_BGR2HSV);
+    int hue = hsv.at<Vec3b>(0,0)[0];
+    
+    Mat imgHSV;
+    cvtColor(img, imgHSV, COLOR_BGR2HSV);
+    dist.create(img.size(), CV_32FC1);
+    for (int y = 0; y < img.rows; y++) {
+        const Vec3b * p = imgHSV.ptr<Vec3b>(y);
+        float * d = dist.ptr<float>(y);
+        for (int x = 0; x < img.cols; x++) {
+            // Hue is 0-179, and wraps around
+            int h = abs(p[x][0] - hue);
+            h = min(h, 180 - h);
+            if (p[x][1] < MIN_SATURATION || p[x][2] < MIN_SATURATION) h = 90;
+            d[x] = h;
+        }
+    }
+    
+    GaussianBlur(dist, dist, Size(0,0), sigma);
+    Sobel(dist, gradX, CV_32F, 1, 0, 3, 1.0/8);
+    Sobel(dist, gradY, CV_32F, 0, 1, 3, 1.0/8);
+}
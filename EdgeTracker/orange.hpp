@@ -20,8 +20,16 @@ using namespace cv;
 
 class orange {
 public:
-    static vector<Vec4i> borderLines(Mat img);
+    static vector<Vec4i> borderLines(Mat img, int numLines = 4);
     static Mat segmentByColour(Mat img, Scalar colour);
+    static void hueDistance(Mat img, Scalar colour, Mat & dist, Mat & gradX, Mat & gradY, double sigma = HUE_SIGMA);
+    
+/*
+ CONSTANTS
+ */
+public:
+    static constexpr double HUE_SIGMA = 4;      // Smoothing (px) of the hue distance, widening its basin
+    static const int MIN_SATURATION = 60;       // Below this saturation (or value) a pixel's hue means nothing
     
 };
 
@@ -0,0 +1,242 @@
+//
+//  preprocess.cpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "preprocess.hpp"
+
+
+void preprocess::edgeMap(Mat frame, Mat & edges, Mat & orientation, Mat & magnitude, bool dilateEdges, int low, int high) {
+    // Finds the (optionally dilated) Canny edges of the frame's luma, the gradient
+    // direction (degrees, 0-179) at each edge pixel and the gradient magnitude (L1,
+    // CV_16SC1) at every pixel. Equivalent to GaussianBlur (3x3),
+    // Canny and dilate (3x3 cross), except that the hysteresis only follows edges
+    // within HALO rows of each band.
+    // frame: 8-bit, 1 or 3 (BGR) channels
+    CV_Assert(frame.depth() == CV_8U && (frame.channels() == 1 || frame.channels() == 3));
+    edges.create(frame.size(), CV_8UC1);
+    orientation.create(frame.size(), CV_8UC1);
+    magnitude.create(frame.size(), CV_16SC1);
+    
+    int numBands = (frame.rows + BAND_ROWS - 1) / BAND_ROWS;
+    parallel_for_(Range(0, numBands), [&](const Range & range) {
+        for (int b = range.start; b < range.end; b++) {
+            int y0 = b * BAND_ROWS;
+            int y1 = min(frame.rows, y0 + BAND_ROWS);
+            edgeBand(frame.data, frame.step, frame.channels(), -1, frame.cols, frame.rows, y0, y1,
+                     edges.data, edges.step, orientation.data, orientation.step,
+                     (short *)magnitude.data, magnitude.step, dilateEdges, low, high);
+        }
+    });
+}
+
+void preprocess::colourEdgeMap(Mat frame, Mat & edges, Mat & magnitude, bool dilateEdges, int low, int high) {
+    // Finds the (optionally dilated) Canny edges of each channel of a BGR frame.
+    // edges: bit c (1 << c) is set where channel c has an edge, so any edge at all is > 0
+    // magnitude: the largest L1 gradient magnitude of the channels (CV_16SC1)
+    // The three channels of a band are done back to back, while it is still in cache.
+    CV_Assert(frame.type() == CV_8UC3);
+    edges.create(frame.size(), CV_8UC1);
+    magnitude.create(frame.size(), CV_16SC1);
+    
+    int numBands = (frame.rows + BAND_ROWS - 1) / BAND_ROWS;
+    parallel_for_(Range(0, numBands), [&](const Range & range) {
+        for (int b = range.start; b < range.end; b++) {
+            int y0 = b * BAND_ROWS;
+            int y1 = min(frame.rows, y0 + BAND_ROWS);
+            for (int c = 0; c < 3; c++) {
+                edgeBand(frame.data, frame.step, 3, c, frame.cols, frame.rows, y0, y1,
+                         edges.data, edges.step, NULL, 0,
+                         (short *)magnitude.data, magnitude.step, dilateEdges, low, high);
+            }
+        }
+    });
+}
+
+void preprocess::edgeBand(const uchar * src, size_t srcStep, int channels, int channel, int width, int height, int y0, int y1,
+                          uchar * edges, size_t edgesStep, uchar * orientation, size_t orientationStep,
+                          short * magnitude, size_t magnitudeStep, bool dilateEdges, int low, int high) {
+    // Processes output rows [y0, y1). Works on a window of rows padded by HALO each side,
+    // with every intermediate image kept in small buffers for the window only.
+    // channel: -1 for the luma (edges are 255), otherwise the one channel to use; its
+    //          edges are bit (1 << channel), combined with the channels before it
+    // orientation, magnitude: optional outputs (may be NULL)
+    int ws = max(0, y0 - HALO);
+    int we = min(height, y1 + HALO);
+    int n = we - ws;
+    int w = width;
+    
+    thread_local vector<uchar> lumaBuf, stateBuf;
+    thread_local vector<short> blurBuf, dxBuf, dyBuf, magBuf;
+    thread_local vector<int> stack;
+    lumaBuf.resize(n*w);
+    blurBuf.resize(n*w);
+    dxBuf.resize(n*w);
+    dyBuf.resize(n*w);
+    magBuf.resize(n*w);
+    stateBuf.resize(n*w);
+    uchar * luma = lumaBuf.data();
+    short * blur = blurBuf.data();
+    short * dx = dxBuf.data();
+    short * dy = dyBuf.data();
+    short * mag = magBuf.data();
+    uchar * state = stateBuf.data();
+    
+    // Rows and columns outside the window are replicated from its edge
+    auto row = [&](int r) {return min(max(r, 0), n - 1);};
+    
+    // 1. Luma (Rec. 601, BGR order)
+    for (int r = 0; r < n; r++) {
+        const uchar * s = src + (ws + r) * srcStep;
+        uchar * l = luma + r*w;
+        if (channels == 1) copy(s, s + w, l);
+        else if (channel >= 0) for (int x = 0; x < w; x++) l[x] = s[channels*x + channel];
+        else for (int x = 0; x < w; x++) l[x] = (uchar)((29*s[3*x] + 150*s[3*x+1] + 77*s[3*x+2] + 128) >> 8);
+    }
+    
+    // 2. Blur: separable [1 2 1]/4 in each direction (a 3x3 Gaussian)
+    for (int r = 0; r < n; r++) {
+        const uchar * a = luma + row(r-1)*w;
+        const uchar * c = luma + r*w;
+        const uchar * b = luma + row(r+1)*w;
+        short * o = blur + r*w;
+        for (int x = 0; x < w; x++) o[x] = a[x] + 2*c[x] + b[x];
+        short left = o[0];
+        for (int x = 0; x < w; x++) {
+            short centre = o[x];
+            short right = o[min(x+1, w-1)];
+            o[x] = (short)((left + 2*centre + right + 8) >> 4);
+            left = centre;
+        }
+    }
+    
+    // 3. Sobel gradients and their L1 magnitude
+    for (int r = 0; r < n; r++) {
+        const short * a = blur + row(r-1)*w;
+        const short * c = blur + r*w;
+        const short * b = blur + row(r+1)*w;
+        short * gx = dx + r*w;
+        short * gy = dy + r*w;
+        short * m = mag + r*w;
+        for (int x = 0; x < w; x++) {
+            int xl = max(x-1, 0), xr = min(x+1, w-1);
+            gx[x] = (short)((a[xr] + 2*c[xr] + b[xr]) - (a[xl] + 2*c[xl] + b[xl]));
+            gy[x] = (short)((b[xl] + 2*b[x] + b[xr]) - (a[xl] + 2*a[x] + a[xr]));
+            m[x] = (short)(abs(gx[x]) + abs(gy[x]));
+        }
+    }
+    
+    // 4. Thinning (non-maximum suppression) and double threshold:
+    //    0 = none, 1 = weak, 2 = strong. As in cv::Canny, the gradient direction is
+    //    binned to horizontal, vertical or diagonal without a division.
+    const int TG22 = (int)(0.4142135623730950488016887242097 * (1 << 15) + 0.5);
+    stack.clear();
+    for (int r = 0; r < n; r++) {
+        uchar * st = state + r*w;
+        const short * m = mag + r*w;
+        const short * ma = mag + row(r-1)*w;
+        const short * mb = mag + row(r+1)*w;
+        const short * gx = dx + r*w;
+        const short * gy = dy + r*w;
+        for (int x = 0; x < w; x++) {
+            st[x] = 0;
+            int v = m[x];
+            if (v <= low) continue;
+            int xl = max(x-1, 0), xr = min(x+1, w-1);
+            int ax = abs(gx[x]), ay = abs(gy[x]);
+            int tg22x = ax * TG22;
+            int y = ay << 15;
+            bool isMax;
+            if (y < tg22x) isMax = v > m[xl] && v >= m[xr];
+            else if (y > tg22x + (ax << 16)) isMax = v > ma[x] && v >= mb[x];
+            else {
+                int s = (gx[x] ^ gy[x]) < 0 ? -1 : 1;
+                int xa = min(max(x - s, 0), w-1), xb = min(max(x + s, 0), w-1);
+                isMax = v > ma[xa] && v > mb[xb];
+            }
+            if (!isMax) continue;
+            if (v > high) {
+                st[x] = 2;
+                stack.push_back(r*w + x);
+            }
+            else st[x] = 1;
+        }
+    }
+    
+    // 5. Hysteresis: grow the strong edges through connected weak ones, within the window
+    while (!stack.empty()) {
+        int i = stack.back();
+        stack.pop_back();
+        int r = i / w, x = i % w;
+        for (int dr = -1; dr <= 1; dr++) {
+            int rr = r + dr;
+            if (rr < 0 || rr >= n) continue;
+            for (int dc = -1; dc <= 1; dc++) {
+                int xx = x + dc;
+                if (xx < 0 || xx >= w) continue;
+                int j = rr*w + xx;
+                if (state[j] == 1) {
+                    state[j] = 2;
+                    stack.push_back(j);
+                }
+            }
+        }
+    }
+    
+    // 6. Output rows: edges (dilated with a 3x3 cross if asked), edge orientations and magnitudes.
+    //    Later channels are merged into the earlier ones' output.
+    uchar mark = channel < 0 ? 255 : (uchar)(1 << channel);
+    bool merge = channel > 0;
+    for (int y = y0; y < y1; y++) {
+        int r = y - ws;
+        if (magnitude != NULL) {
+            short * mo = (short *)((uchar *)magnitude + y*magnitudeStep);
+            if (merge) for (int x = 0; x < w; x++) mo[x] = max(mo[x], mag[r*w + x]);
+            else copy(mag + r*w, mag + (r+1)*w, mo);
+        }
+        const uchar * c = state + r*w;
+        const uchar * a = state + row(r-1)*w;
+        const uchar * b = state + row(r+1)*w;
+        uchar * e = edges + y*edgesStep;
+        uchar * o = orientation == NULL ? NULL : orientation + y*orientationStep;
+        const short * gx = dx + r*w;
+        const short * gy = dy + r*w;
+        for (int x = 0; x < w; x++) {
+            bool edge = c[x] == 2;
+            if (dilateEdges) {
+                // Only use rows beyond the image if the window really has them
+                bool above = (y > 0) && a[x] == 2;
+                bool below = (y < height - 1) && b[x] == 2;
+                edge = edge || above || below || (x > 0 && c[x-1] == 2) || (x < w-1 && c[x+1] == 2);
+            }
+            if (merge) e[x] |= edge ? mark : 0;
+            else e[x] = edge ? mark : 0;
+            if (o == NULL) continue;
+            if (c[x] == 2) {
+                float angle = atan2f((float)gy[x], (float)gx[x]) * (float)(180.0 / CV_PI);
+                if (angle < 0) angle += 180;
+                o[x] = (uchar)min((int)angle, 179);
+            }
+            else o[x] = 0;
+        }
+    }
+}
+
+void preprocess::gradientMagnitude(Mat blurred, Mat & magnitude) {
+    // The L1 Sobel gradient magnitude (CV_16SC1) of an already blurred frame, as
+    // given by edgeMap. For when the edges were found the unfused way.
+    Mat gray, dx, dy;
+    if (blurred.channels() == 3) cvtColor(blurred, gray, CV_BGR2GRAY);
+    else gray = blurred;
+    Sobel(gray, dx, CV_16S, 1, 0);
+    Sobel(gray, dy, CV_16S, 0, 1);
+    magnitude.create(blurred.size(), CV_16SC1);
+    add(abs(dx), abs(dy), magnitude);
+}
@@ -0,0 +1,54 @@
+//
+//  preprocess.hpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#ifndef preprocess_hpp
+#define preprocess_hpp
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <iostream>
+#include <stdio.h>
+
+using namespace std;
+using namespace cv;
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+//      Frame preprocessing fused into one pass: the frame is cut
+//      into bands of rows, and each band is blurred, differentiated,
+//      thinned, thresholded and dilated while it is still in cache.
+//      The bands are processed in parallel.
+//      The colour version finds the edges of each channel separately
+//      and packs them into one byte per pixel: bit c is set where
+//      channel c has an edge, so any channel is tested with one load.
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+class preprocess {
+    
+/*
+ METHODS
+ */
+public:
+    static void edgeMap(Mat frame, Mat & edges, Mat & orientation, Mat & magnitude, bool dilateEdges = true, int low = LOW_THRESHOLD, int high = HIGH_THRESHOLD);
+    static void colourEdgeMap(Mat frame, Mat & edges, Mat & magnitude, bool dilateEdges = true, int low = LOW_THRESHOLD, int high = HIGH_THRESHOLD);
+    static void edgeBand(const uchar * src, size_t srcStep, int channels, int channel, int width, int height, int y0, int y1,
+                         uchar * edges, size_t edgesStep, uchar * orientation, size_t orientationStep,
+                         short * magnitude, size_t magnitudeStep, bool dilateEdges, int low, int high);
+    static void gradientMagnitude(Mat blurred, Mat & magnitude);
+    
+/*
+ CONSTANTS
+ */
+public:
+    static const int LOW_THRESHOLD = 20;    // Canny thresholds (on the L1 Sobel gradient)
+    static const int HIGH_THRESHOLD = 60;
+    static const int BAND_ROWS = 16;        // Output rows per band
+    static const int HALO = 4;              // Extra rows each side: 1 each for the blur, Sobel, thinning and dilation
+    
+};
+
+#endif /* preprocess_hpp */
@@ -0,0 +1,173 @@
+//
+//  profiler.cpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+
+#include "profiler.hpp"
+
+bool Profiler::tracing = true;
+
+namespace {
+    struct Event {
+        Stage stage;
+        long long start, end;
+    };
+    
+    struct Timeline {
+        int thread;
+        vector<Event> events;
+    };
+    
+    // Histogram counts, updated without locking from any thread
+    atomic<long long> histograms[NUM_STAGES][Profiler::NUM_BUCKETS];
+    
+    // Every thread's timeline, kept after the thread ends
+    mutex timelinesLock;
+    vector<shared_ptr<Timeline>> timelines;
+    
+    const chrono::steady_clock::time_point origin = chrono::steady_clock::now();
+    
+    Timeline * localTimeline() {
+        thread_local shared_ptr<Timeline> timeline;
+        if (!timeline) {
+            timeline = make_shared<Timeline>();
+            lock_guard<mutex> guard(timelinesLock);
+            timeline->thread = (int)timelines.size();
+            timelines.push_back(timeline);
+        }
+        return timeline.get();
+    }
+}
+
+
+// * * * * * * * * * * * * * * *
+//      Recording
+// * * * * * * * * * * * * * * *
+
+long long Profiler::now() {
+    // Nanoseconds since the program started
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - origin).count();
+}
+
+void Profiler::record(Stage stage, long long start, long long end) {
+    histograms[stage][bucket(end - start)].fetch_add(1, memory_order_relaxed);
+    
+    if (tracing) {
+        Timeline * timeline = localTimeline();
+        if (timeline->events.size() < MAX_EVENTS) timeline->events.push_back({stage, start, end});
+    }
+}
+
+void Profiler::reset() {
+    // Only call when no stage is being timed
+    for (int s = 0; s < NUM_STAGES; s++) {
+        for (int b = 0; b < NUM_BUCKETS; b++) histograms[s][b] = 0;
+    }
+    lock_guard<mutex> guard(timelinesLock);
+    for (int t = 0; t < timelines.size(); t++) timelines[t]->events.clear();
+}
+
+
+// * * * * * * * * * * * * * * *
+//      Histograms
+// * * * * * * * * * * * * * * *
+
+int Profiler::bucket(long long ns) {
+    // Log-linear buckets: exact below SUB_BUCKETS ns, then SUB_BUCKETS per doubling
+    if (ns < SUB_BUCKETS) return (int)max(ns, 0LL);
+    int e = 63 - __builtin_clzll(ns);
+    int sub = (int)(ns >> (e - 3)) - SUB_BUCKETS;
+    return min((e - 2) * SUB_BUCKETS + sub, NUM_BUCKETS - 1);
+}
+
+long long Profiler::bucketValue(int b) {
+    // The middle of the range of durations in bucket b
+    if (b < SUB_BUCKETS) return b;
+    int e = b / SUB_BUCKETS + 2;
+    long long width = 1LL << (e - 3);
+    return (SUB_BUCKETS + b % SUB_BUCKETS) * width + width / 2;
+}
+
+long long Profiler::count(Stage stage) {
+    long long total = 0;
+    for (int b = 0; b < NUM_BUCKETS; b++) total += histograms[stage][b].load(memory_order_relaxed);
+    return total;
+}
+
+double Profiler::percentile(Stage stage, double p) {
+    // The p-th percentile (0-100) of the stage's durations, in ms
+    long long total = count(stage);
+    if (total == 0) return 0;
+    
+    long long target = max(1LL, (long long)ceil(p / 100.0 * total));
+    long long cumulative = 0;
+    for (int b = 0; b < NUM_BUCKETS; b++) {
+        cumulative += histograms[stage][b].load(memory_order_relaxed);
+        if (cumulative >= target) return bucketValue(b) / 1e6;
+    }
+    return bucketValue(NUM_BUCKETS - 1) / 1e6;
+}
+
+void Profiler::report() {
+    cout << "Stage          Count       p50      p95      p99 (ms)" << endl;
+    for (int s = 0; s < NUM_STAGES; s++) {
+        Stage stage = Stage(s);
+        long long n = count(stage);
+        if (n == 0) continue;
+        printf("%-12s %8lli   %6.3f   %6.3f   %6.3f\n", stageName(stage), n,
+               percentile(stage, 50), percentile(stage, 95), percentile(stage, 99));
+    }
+}
+
+
+// * * * * * * * * * * * * * * *
+//      Timeline
+// * * * * * * * * * * * * * * *
+
+bool Profiler::writeTrace(string path) {
+    // Writes every thread's timeline in the Chrome trace event format
+    // (open with chrome://tracing). Only call when no stage is being timed.
+    ofstream file(path);
+    if (!file.is_open()) return false;
+    
+    lock_guard<mutex> guard(timelinesLock);
+    file << fixed << setprecision(3);
+    file << "{\"traceEvents\":[";
+    bool first = true;
+    for (int t = 0; t < timelines.size(); t++) {
+        vector<Event> & events = timelines[t]->events;
+        for (int i = 0; i < events.size(); i++) {
+            if (!first) file << ",";
+            first = false;
+            file << "\n{\"name\":\"" << stageName(events[i].stage) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << timelines[t]->thread
+                 << ",\"ts\":" << events[i].start / 1000.0 << ",\"dur\":" << (events[i].end - events[i].start) / 1000.0 << "}";
+        }
+    }
+    file << "\n]}\n";
+    
+    return true;
+}
+
+const char * Profiler::stageName(Stage stage) {
+    switch (stage) {
+        case STAGE_BLUR:        return "blur";
+        case STAGE_CANNY:       return "canny";
+        case STAGE_DILATE:      return "dilate";
+        case STAGE_PREPROCESS:  return "preprocess";
+        case STAGE_WHISKERS:    return "whiskers";
+        case STAGE_EDGE_SEARCH: return "edge search";
+        case STAGE_SOLVE:       return "solve";
+        case STAGE_DRAW:        return "draw";
+        case STAGE_SEGMENT:     return "segment";
+        case STAGE_AREA_ERROR:  return "area error";
+        case STAGE_REGION:      return "region";
+        default:                return "?";
+    }
+}
@@ -0,0 +1,102 @@
+//
+//  profiler.hpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#ifndef profiler_hpp
+#define profiler_hpp
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <stdio.h>
+
+using namespace std;
+
+
+// * * * * * * * * * * * * * * *
+//      Stages of the hot path
+// * * * * * * * * * * * * * * *
+
+enum Stage {
+    STAGE_BLUR,
+    STAGE_CANNY,
+    STAGE_DILATE,
+    STAGE_PREPROCESS,   // Fused blur, Canny and dilation
+    STAGE_WHISKERS,     // Projecting the model to whiskers
+    STAGE_EDGE_SEARCH,  // Searching along the whiskers
+    STAGE_SOLVE,        // Least squares pose estimation
+    STAGE_DRAW,
+    STAGE_SEGMENT,
+    STAGE_AREA_ERROR,
+    STAGE_REGION,       // Region refinement, after segmenting
+    NUM_STAGES
+};
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+//      Collects the time spent in each stage into latency histograms
+//      and, optionally, a per-thread timeline of every stage
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+class Profiler {
+    
+/*
+ METHODS
+ */
+public:
+    static long long now();
+    static void record(Stage stage, long long start, long long end);
+    static double percentile(Stage stage, double p);
+    static long long count(Stage stage);
+    static void report();
+    static bool writeTrace(string path);
+    static void reset();
+    static const char * stageName(Stage stage);
+    
+private:
+    static int bucket(long long ns);
+    static long long bucketValue(int b);
+    
+/*
+ CONSTANTS
+ */
+public:
+    static const int SUB_BUCKETS = 8;           // Histogram buckets per doubling of the duration
+    static const int NUM_BUCKETS = 40 * SUB_BUCKETS;
+    static const int MAX_EVENTS = 1 << 20;      // Max timeline events kept per thread
+    static bool tracing;                        // Whether to keep the timeline (the histograms are always kept)
+};
+
+
+// * * * * * * * * * * * * * * *
+//      ScopedTimer
+// * * * * * * * * * * * * * * *
+
+class ScopedTimer {
+public:
+    ScopedTimer(Stage stage_in) : stage(stage_in), start(Profiler::now()) {}
+    ~ScopedTimer() {Profiler::record(stage, start, Profiler::now());}
+    
+private:
+    Stage stage;
+    long long start;
+};
+
+
+// Times the rest of the enclosing scope as the given stage. Compiled out
+// entirely unless PROFILING is defined.
+#ifdef PROFILING
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(stage) ScopedTimer PROFILE_CONCAT(scopedTimer_, __LINE__)(stage)
+#else
+#define PROFILE_SCOPE(stage)
+#endif
+
+#endif /* profiler_hpp */
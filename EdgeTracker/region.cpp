@@ -0,0 +1,106 @@
+//
+//  region.cpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#include "region.hpp"
+
+const float region::MAX_DIST = 10;
+
+
+bool region::signedDistance(Mat seg, Mat & sdf, Mat & gradX, Mat & gradY) {
+    // The distance (px) of each pixel from the edge of the segmented region: positive
+    // outside it, negative inside, and zero half way between inside and outside pixels.
+    // seg: segmented image, non-zero inside the region (see orange::segmentByColour)
+    // gradX, gradY: its image gradients (per pixel)
+    // Returns false if the region is empty or fills the whole image.
+    Mat mask = seg;
+    if (seg.channels() == 3) cvtColor(seg, mask, CV_BGR2GRAY);
+    mask = mask > 0;
+    int numInside = countNonZero(mask);
+    if (numInside == 0 || (size_t)numInside == mask.total()) return false;
+    
+    Mat inside, outside;
+    distanceTransform(mask, inside, DIST_L2, DIST_MASK_3);
+    distanceTransform(~mask, outside, DIST_L2, DIST_MASK_3);
+    subtract(outside, inside, sdf);
+    add(sdf, 0.5, sdf, mask);
+    subtract(sdf, 0.5, sdf, ~mask);
+    
+    Sobel(sdf, gradX, CV_32F, 1, 0, 3, 1.0/8);
+    Sobel(sdf, gradY, CV_32F, 0, 1, 3, 1.0/8);
+    return true;
+}
+
+Mat region::outlinePoints(const Model * model, int numPoints) {
+    // Points spaced evenly around a planar model's outline (model coords, 4 x N).
+    // The vertices of a planar model are in order around it.
+    Mat vertices = model->pointsToMat();
+    int n = vertices.cols;
+    vector<double> lengths(n);
+    double perimeter = 0;
+    for (int i = 0; i < n; i++) {
+        lengths[i] = norm(vertices.col((i + 1) % n) - vertices.col(i));
+        perimeter += lengths[i];
+    }
+    
+    Mat points = Mat(4, numPoints, CV_32FC1);
+    int edge = 0;
+    double edgeStart = 0;
+    for (int p = 0; p < numPoints; p++) {
+        double s = perimeter * (p + 0.5) / numPoints;
+        while (edge < n - 1 && s > edgeStart + lengths[edge]) edgeStart += lengths[edge++];
+        double t = (s - edgeStart) / max(lengths[edge], 1e-6);
+        Mat point = vertices.col(edge) * (1 - t) + vertices.col((edge + 1) % n) * t;
+        point.copyTo(points.col(p));
+    }
+    return points;
+}
+
+estimate region::refine(Vec6f pose1, Mat points, Mat K, Mat sdf, Mat gradX, Mat gradY, int maxIter, const Distortion * dist) {
+    // Gauss-Newton on the signed distance at the projected outline points, with the
+    // analytic Jacobian (the distance gradient times the projection's Jacobian)
+    // pose1: initial pose parameters
+    // points: outline points (model coords), see outlinePoints
+    // K: intrinsic matrix, shifted to the window that 'sdf' covers
+    // sdf, gradX, gradY: see signedDistance
+    // Points more than MAX_DIST from the edge (e.g. occluded) count as MAX_DIST, and don't pull.
+    SE3 T = SE3::fromPose(pose1);
+    Mat r = lsq::coloursAtPoints(sdf, lsq::projection(T, points, K, dist));
+    auto error = [](Mat r) {
+        double E = 0;
+        for (int i = 0; i < r.rows; i++) E += min(r.at<float>(i) * r.at<float>(i), MAX_DIST * MAX_DIST);
+        return E / max(r.rows, 1);
+    };
+    double E = error(r);
+    
+    int iterations = 0;
+    while (iterations < maxIter) {
+        Mat J = lsq::jacobianColour(T, points, K, gradX, gradY, dist);
+        for (int i = 0; i < r.rows; i++) {
+            if (fabs(r.at<float>(i)) <= MAX_DIST) continue;
+            J.row(i).setTo(0);
+            r.at<float>(i) = 0;
+        }
+        
+        Mat del;
+        if (!solve(J.t() * J, -J.t() * r, del, DECOMP_CHOLESKY)) break;
+        SE3 T2 = SE3::exp(Vec6f((float *)del.data)) * T;
+        Mat r2 = lsq::coloursAtPoints(sdf, lsq::projection(T2, points, K, dist));
+        double E2 = error(r2);
+        iterations++;
+        
+        // As lsq: never accept a worse pose, and stop when the steps stop paying
+        if (E2 >= E) break;
+        double improvement = (E - E2)/E;
+        r = r2;
+        E = E2;
+        T = T2;
+        if (improvement < lsq::MIN_IMPROVEMENT) break;
+    }
+    
+    return estimate(T.toPose(), E, iterations);
+}
@@ -0,0 +1,51 @@
+//
+//  region.hpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#ifndef region_hpp
+#define region_hpp
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <iostream>
+#include <stdio.h>
+
+#include "distortion.hpp"
+#include "lsq.hpp"
+#include "models.hpp"
+
+using namespace std;
+using namespace cv;
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+//      Region-based pose refinement: points along a planar model's
+//      outline are pulled onto the edge of its colour region, where
+//      the signed distance to the segmented region is zero.
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+class region {
+    
+/*
+ METHODS
+ */
+public:
+    static bool signedDistance(Mat seg, Mat & sdf, Mat & gradX, Mat & gradY);
+    static Mat outlinePoints(const Model * model, int numPoints = OUTLINE_POINTS);
+    static estimate refine(Vec6f pose1, Mat points, Mat K, Mat sdf, Mat gradX, Mat gradY, int maxIter = MAX_ITERATIONS, const Distortion * dist = NULL);
+    
+/*
+ CONSTANTS
+ */
+public:
+    static const int OUTLINE_POINTS = 64;   // Samples along the outline
+    static const int MAX_ITERATIONS = 5;
+    static const int MARGIN = 16;           // Around the projected model, the window (px) that is segmented
+    static const float MAX_DIST;            // Samples further (px) from the region's edge are ignored
+    
+};
+
+#endif /* region_hpp */
@@ -0,0 +1,60 @@
+//
+//  ring.hpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#ifndef ring_hpp
+#define ring_hpp
+
+#include <atomic>
+#include <stdio.h>
+
+using namespace std;
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+//      A fixed-size, lock-free queue for exactly one producer thread
+//      and one consumer thread. Neither side ever blocks: push fails
+//      when the ring is full and pop fails when it is empty.
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+template <typename T, int N>
+class RingBuffer {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "RingBuffer size must be a power of two");
+    
+public:
+    RingBuffer() : head(0), tail(0) {}
+    
+    bool push(const T & item) {
+        // Producer only
+        size_t h = head.load(memory_order_relaxed);
+        if (h - tail.load(memory_order_acquire) == N) return false;
+        items[h & (N - 1)] = item;
+        head.store(h + 1, memory_order_release);
+        return true;
+    }
+    
+    bool pop(T & item) {
+        // Consumer only
+        size_t t = tail.load(memory_order_relaxed);
+        if (t == head.load(memory_order_acquire)) return false;
+        item = items[t & (N - 1)];
+        tail.store(t + 1, memory_order_release);
+        return true;
+    }
+    
+    bool empty() const {return head.load(memory_order_acquire) == tail.load(memory_order_acquire);}
+    
+private:
+    // Keep the two indices on separate cache lines so the threads don't contend.
+    // (Padding rather than alignas, so that the ring can live on the heap.)
+    atomic<size_t> head;
+    char padHead[64 - sizeof(atomic<size_t>)];
+    atomic<size_t> tail;
+    char padTail[64 - sizeof(atomic<size_t>)];
+    T items[N];
+};
+
+#endif /* ring_hpp */
@@ -0,0 +1,97 @@
+//
+//  scenarios.cpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#include "scenarios.hpp"
+
+
+// * * * * * * * * * * * * * * * * *
+//   SCENARIO
+// * * * * * * * * * * * * * * * * *
+
+bool Scenario::read(FileNode node, Scenario & scenario) {
+    // Reads the name, models and (optional) starting poses of one scenario or stream:
+    //   { name: "...", models: [ "Arrow", ... ], poses: [ [x, y, z, rx, ry, rz], ... ] }
+    // Returns false, saying why, if a model is unknown or the poses don't match them.
+    scenario = Scenario();
+    node["name"] >> scenario.name;
+    
+    vector<string> modelNames;
+    node["models"] >> modelNames;
+    for (int i = 0; i < modelNames.size(); i++) {
+        shared_ptr<const Model> model = Model::byName(modelNames[i]);
+        if (!model) {
+            cout << scenario.name << ": unknown model " << modelNames[i] << endl;
+            return false;
+        }
+        scenario.models.push_back(model);
+    }
+    if (scenario.models.empty()) {
+        cout << scenario.name << ": no models" << endl;
+        return false;
+    }
+    
+    FileNode poses = node["poses"];
+    for (FileNodeIterator p = poses.begin(); p != poses.end(); ++p) {
+        vector<float> pose;
+        (*p) >> pose;
+        if (pose.size() != 6) continue;
+        scenario.est.push_back(estimate(Vec6f(pose[0], pose[1], pose[2], pose[3], pose[4], pose[5]), 0, 0));
+    }
+    if (!scenario.est.empty() && scenario.est.size() != scenario.models.size()) {
+        cout << scenario.name << ": needs one pose per model" << endl;
+        return false;
+    }
+    return true;
+}
+
+vector<const Model *> Scenario::modelPointers() const {
+    vector<const Model *> ret;
+    for (int i = 0; i < models.size(); i++) ret.push_back(models[i].get());
+    return ret;
+}
+
+
+// * * * * * * * * * * * * * * * * *
+//   CATALOGUE
+// * * * * * * * * * * * * * * * * *
+
+bool ScenarioCatalogue::load(string path) {
+    // Reads every scenario in the file; returns false if it can't be read or any is invalid
+    FileStorage fs(path, FileStorage::READ);
+    if (!fs.isOpened()) {
+        cout << "Could not open " << path << endl;
+        return false;
+    }
+    if (!fs["fx"].empty()) {
+        float fx, fy, cx, cy;
+        fs["fx"] >> fx;
+        fs["fy"] >> fy;
+        fs["cx"] >> cx;
+        fs["cy"] >> cy;
+        K = (Mat_<float>(3, 3) << fx, 0, cx, 0, fy, cy, 0, 0, 1);
+    }
+    if (!fs["data"].empty()) fs["data"] >> dataFolder;
+    if (!fs["templates"].empty()) fs["templates"] >> templateFolder;
+    
+    scenarios.clear();
+    FileNode list = fs["scenarios"];
+    for (FileNodeIterator it = list.begin(); it != list.end(); ++it) {
+        Scenario scenario;
+        if (!Scenario::read(*it, scenario)) return false;
+        scenarios.push_back(scenario);
+    }
+    return true;
+}
+
+const Scenario * ScenarioCatalogue::find(string name) const {
+    // Returns the scenario with the given name, or NULL
+    for (int i = 0; i < scenarios.size(); i++) {
+        if (scenarios[i].name == name) return &scenarios[i];
+    }
+    return NULL;
+}
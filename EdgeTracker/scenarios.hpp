@@ -0,0 +1,57 @@
+//
+//  scenarios.hpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#ifndef scenarios_hpp
+#define scenarios_hpp
+
+#include <opencv2/core/core.hpp>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <stdio.h>
+
+#include "lsq.hpp"
+#include "models.hpp"
+
+using namespace std;
+using namespace cv;
+
+
+// * * * * * * * * * * * * * * *
+//      Scenario
+// * * * * * * * * * * * * * * *
+
+class Scenario {
+public:
+    static bool read(FileNode node, Scenario & scenario);
+    vector<const Model *> modelPointers() const;
+    
+public:
+    string name;                                // Also the name of its video, without the extension
+    vector<shared_ptr<const Model>> models;     // Keeps the (shared) models alive
+    vector<estimate> est;                       // Starting poses, one per model (empty: found by the tracker)
+};
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+//      The test sequences, read from a config file (see scenarios.yml)
+//      so that they can be changed or added without recompiling.
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+class ScenarioCatalogue {
+public:
+    bool load(string path);
+    const Scenario * find(string name) const;
+    
+public:
+    vector<Scenario> scenarios;
+    Mat K;                      // The camera's intrinsic matrix (empty if not given)
+    string dataFolder;          // Where the videos are (empty if not given)
+    string templateFolder;      // Where the template banks are (empty if not given)
+};
+
+#endif /* scenarios_hpp */
@@ -0,0 +1,106 @@
+//
+//  se3.cpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#include <cmath>
+
+#include "se3.hpp"
+
+const float SE3::SMALL_ANGLE = 1e-4;
+
+
+static Matx33f hat(Vec3f w) {
+    // The cross product matrix of w, i.e. hat(w) * x = w x x
+    return Matx33f(    0, -w[2],  w[1],
+                    w[2],     0, -w[0],
+                   -w[1],  w[0],     0);
+}
+
+SE3 SE3::fromPose(Vec6f pose) {
+    // From a pose vector (tx, ty, tz, rx, ry, rz): rotate about the x, y then z axes
+    // (as lsq::rotation), then translate
+    float cx = cos(pose[3]), sx = sin(pose[3]);
+    float cy = cos(pose[4]), sy = sin(pose[4]);
+    float cz = cos(pose[5]), sz = sin(pose[5]);
+    Matx33f R = Matx33f(cz*cy,  cz*sy*sx - sz*cx,   cz*sy*cx + sz*sx,
+                        sz*cy,  sz*sy*sx + cz*cx,   sz*sy*cx - cz*sx,
+                          -sy,             cy*sx,              cy*cx);
+    return SE3(R, Vec3f(pose[0], pose[1], pose[2]));
+}
+
+Vec6f SE3::toPose() const {
+    // Back to a pose vector, with the angles in (-PI,PI] (thanks to Gregory Slabaugh)
+    float rY = -asin(min(max(R(2,0), -1.f), 1.f));
+    float rX = atan2(R(2,1), R(2,2));
+    float rZ = atan2(R(1,0), R(0,0));
+    return Vec6f(t[0], t[1], t[2], rX, rY, rZ);
+}
+
+SE3 SE3::exp(Vec6f twist) {
+    // The transform reached by following the twist (v, w) for unit time (Rodrigues)
+    Vec3f v = Vec3f(twist[0], twist[1], twist[2]);
+    Vec3f w = Vec3f(twist[3], twist[4], twist[5]);
+    float theta = norm(w);
+    
+    float A, B, C;
+    if (theta < SMALL_ANGLE) {
+        A = 1 - theta*theta / 6;
+        B = 0.5 - theta*theta / 24;
+        C = 1.0/6 - theta*theta / 120;
+    }
+    else {
+        A = sin(theta) / theta;
+        B = (1 - cos(theta)) / (theta*theta);
+        C = (theta - sin(theta)) / (theta*theta*theta);
+    }
+    
+    Matx33f W = hat(w);
+    Matx33f W2 = W * W;
+    Matx33f I = Matx33f::eye();
+    return SE3(I + A*W + B*W2, (I + B*W + C*W2) * v);
+}
+
+Vec6f SE3::log() const {
+    // The twist whose exp is this transform
+    float cosTheta = min(max((R(0,0) + R(1,1) + R(2,2) - 1) / 2, -1.f), 1.f);
+    float theta = acos(cosTheta);
+    Vec3f vee = Vec3f(R(2,1) - R(1,2), R(0,2) - R(2,0), R(1,0) - R(0,1));
+    
+    Vec3f w;
+    if (theta < SMALL_ANGLE) w = 0.5 * vee;
+    else if (theta < CV_PI - 1e-3) w = theta / (2 * sin(theta)) * vee;
+    else {
+        // Near a half turn R is almost symmetric, and the axis is taken from
+        // R + I = 2aa' (its largest column), signed to agree with the vee part
+        int k = 0;
+        for (int i = 1; i < 3; i++) if (R(i,i) > R(k,k)) k = i;
+        Vec3f a = Vec3f(R(0,k), R(1,k), R(2,k));
+        a[k] += 1;
+        a *= 1 / norm(a);
+        if (a.dot(vee) < 0) a = -a;
+        w = theta * a;
+    }
+    
+    // Undo the coupling of the translation with the rotation
+    float D;
+    if (theta < SMALL_ANGLE) D = 1.0/12;
+    else D = (1 - theta * sin(theta) / (2 * (1 - cosTheta))) / (theta*theta);
+    Matx33f W = hat(w);
+    Vec3f v = (Matx33f::eye() - 0.5*W + D*(W*W)) * t;
+    
+    return Vec6f(v[0], v[1], v[2], w[0], w[1], w[2]);
+}
+
+Mat SE3::matrix() const {
+    // The 3x4 matrix [R | t]
+    Mat P = Mat(3, 4, CV_32FC1);
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) P.at<float>(i, j) = R(i, j);
+        P.at<float>(i, 3) = t[i];
+    }
+    return P;
+}
@@ -0,0 +1,57 @@
+//
+//  se3.hpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#ifndef se3_hpp
+#define se3_hpp
+
+#include <opencv2/core/core.hpp>
+#include <iostream>
+#include <stdio.h>
+
+using namespace std;
+using namespace cv;
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+//      A rigid transform (model to camera), kept as a rotation matrix
+//      and a translation. Unlike the Euler angle pose vector it has
+//      no wrap-around or gimbal lock, and inverts and composes in
+//      closed form. Small changes are given as twists
+//      (tx, ty, tz, wx, wy, wz), in the same order as a Vec6f pose,
+//      and applied on the left: exp(twist) * T.
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+class SE3 {
+    
+/*
+ METHODS
+ */
+public:
+    SE3() : R(Matx33f::eye()), t(0, 0, 0) {}
+    SE3(Matx33f R_in, Vec3f t_in) : R(R_in), t(t_in) {}
+    static SE3 fromPose(Vec6f pose);
+    Vec6f toPose() const;
+    static SE3 exp(Vec6f twist);
+    Vec6f log() const;
+    SE3 inverse() const {return SE3(R.t(), -(R.t() * t));}
+    SE3 operator * (const SE3 & T) const {return SE3(R * T.R, R * T.t + t);}
+    Vec3f operator * (const Vec3f & x) const {return R * x + t;}
+    Mat matrix() const;
+    
+public:
+    Matx33f R;
+    Vec3f t;
+    
+/*
+ CONSTANTS
+ */
+public:
+    static const float SMALL_ANGLE;     // Below this (rad), exp and log use their series expansions
+    
+};
+
+#endif /* se3_hpp */
@@ -0,0 +1,80 @@
+//
+//  sources.cpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#include <stdlib.h>
+
+#include "sources.hpp"
+#include "capture.hpp"
+#include "framecache.hpp"
+
+
+// * * * * * * * * * * * * * * *
+//      FrameSource
+// * * * * * * * * * * * * * * *
+
+FrameSource * FrameSource::open(string uri, Size size) {
+    // Opens the source described by 'uri' (see sources.hpp), or returns NULL.
+    // size: the frame size, needed for raw sources
+    if (uri.compare(0, 5, "live:") == 0) {
+        FrameSource * source = open(uri.substr(5), size);
+        if (source != NULL) return new LiveSource(source);
+    }
+    else if (uri.compare(0, 6, "paced:") == 0) {
+        size_t colon = uri.find(':', 6);
+        double fps = atof(uri.substr(6, colon - 6).c_str());
+        FrameSource * source = (colon != string::npos && fps > 0) ? open(uri.substr(colon + 1), size) : NULL;
+        if (source != NULL) return new PacedSource(source, fps);
+    }
+    else if (uri.compare(0, 4, "raw:") == 0) {
+        RawSource * source = new RawSource(uri.substr(4), size);
+        if (source->isOpened()) return source;
+        delete source;
+    }
+    else if (uri.compare(0, 6, "cache:") == 0) {
+        MappedFrameSource * source = new MappedFrameSource(uri.substr(6));
+        if (source->isOpened()) return source;
+        delete source;
+    }
+    else if (uri.compare(0, 7, "camera:") == 0) {
+        VideoSource * source = new VideoSource(stoi(uri.substr(7)));
+        if (source->isOpened()) return source;
+        delete source;
+    }
+    else {
+        VideoSource * source = new VideoSource(uri);
+        if (source->isOpened()) return source;
+        delete source;
+    }
+    return NULL;
+}
+
+
+// * * * * * * * * * * * * * * *
+//      RawSource
+// * * * * * * * * * * * * * * *
+
+RawSource::RawSource(string path, Size size_in) : size(size_in) {
+    file = (size.area() > 0) ? fopen(path.c_str(), "rb") : NULL;
+}
+
+RawSource::~RawSource() {
+    if (file != NULL) fclose(file);
+}
+
+bool RawSource::read(Mat & frame) {
+    // Frames already handed out stay valid: only buffers nobody holds are reused
+    if (file == NULL) return false;
+    frame = Mat();
+    frame = pool.acquire(size, CV_8UC3);
+    size_t numBytes = frame.total() * frame.elemSize();
+    if (fread(frame.data, 1, numBytes, file) != numBytes) {
+        frame = Mat();
+        return false;
+    }
+    return true;
+}
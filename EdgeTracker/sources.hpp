@@ -0,0 +1,88 @@
+//
+//  sources.hpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#ifndef sources_hpp
+#define sources_hpp
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/videoio/videoio.hpp>
+#include <chrono>
+#include <iostream>
+#include <stdio.h>
+
+#include "framecontext.hpp"
+
+using namespace std;
+using namespace cv;
+
+
+// * * * * * * * * * * * * * * *
+//      FrameSource
+// * * * * * * * * * * * * * * *
+
+class FrameSource {
+public:
+    virtual ~FrameSource() {}
+    virtual bool read(Mat & frame) = 0;
+    virtual chrono::steady_clock::time_point getCaptureTime() const {return chrono::steady_clock::time_point();} // Of the last frame read (zero: not known)
+    virtual long long getDropped() const {return 0;}    // Frames skipped so far, to keep up
+    static FrameSource * open(string uri, Size size = Size());
+};
+
+
+// * * * * * * * * * * * * * * *
+//      VideoSource
+// * * * * * * * * * * * * * * *
+
+class VideoSource : public FrameSource {
+public:
+    VideoSource(string path) : cap(path) {}
+    VideoSource(int camera) : cap(camera) {}
+    bool isOpened() {return cap.isOpened();}
+    bool read(Mat & frame) {cap >> frame; return !frame.empty();}
+    
+private:
+    VideoCapture cap;
+};
+
+
+// * * * * * * * * * * * * * * *
+//      RawSource
+// * * * * * * * * * * * * * * *
+
+class RawSource : public FrameSource {
+public:
+    RawSource(string path, Size size_in);
+    ~RawSource();
+    bool isOpened() {return file != NULL;}
+    bool read(Mat & frame);
+    
+private:
+    FILE * file;
+    Size size;
+    BufferPool pool;
+};
+
+
+/*
+
+ Source URIs:
+    <path>          A video file, read with VideoCapture
+    camera:<n>      Camera no. n
+    raw:<path>      Back-to-back 8-bit BGR frames of a given size, read from a
+                    file or a named pipe (e.g. the output of ffmpeg -f rawvideo)
+    cache:<path>    A frame cache made by the FrameCache tool, read from memory
+                    (see framecache.hpp)
+    live:<uri>      Any of the above, read on its own thread, always handing out
+                    the newest frame (see capture.hpp)
+    paced:<fps>:<uri>   Any of the above, delivered at a fixed rate, e.g.
+                    live:paced:30:<video> to replay a video as a live camera
+
+ */
+
+#endif /* sources_hpp */
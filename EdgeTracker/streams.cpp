@@ -0,0 +1,157 @@
+//
+//  streams.cpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#include <algorithm>
+#include <set>
+
+#include "streams.hpp"
+#include "scenarios.hpp"
+#include "templates.hpp"
+
+
+// * * * * * * * * * * * * * * *
+//      Stream
+// * * * * * * * * * * * * * * *
+
+Stream::Stream(string name_in, FrameSource * source_in, vector<shared_ptr<const Model>> models_in, Mat K, vector<estimate> est)
+    : name(name_in), source(source_in), models(models_in), tracker(modelPointers(models_in), K, est) {}
+
+vector<const Model *> Stream::modelPointers(vector<shared_ptr<const Model>> models) {
+    vector<const Model *> ret;
+    for (int i = 0; i < models.size(); i++) ret.push_back(models[i].get());
+    return ret;
+}
+
+
+// * * * * * * * * * * * * * * *
+//      StreamServer
+// * * * * * * * * * * * * * * *
+
+void StreamServer::addStream(Stream * stream) {
+    // Busy models share the stream workers too, when they are free
+    stream->tracker.pool = &pool;
+    streams.push_back(unique_ptr<Stream>(stream));
+}
+
+bool StreamServer::loadConfig(string path) {
+    // Adds the streams described in a config file (see streams.hpp)
+    FileStorage fs(path, FileStorage::READ);
+    if (!fs.isOpened()) {
+        cout << "Could not open " << path << endl;
+        return false;
+    }
+    if (!fs["templates"].empty()) fs["templates"] >> templateFolder;
+    
+    FileNode list = fs["streams"];
+    for (FileNodeIterator it = list.begin(); it != list.end(); ++it) {
+        FileNode node = *it;
+        Scenario scenario;
+        if (!Scenario::read(node, scenario)) return false;
+        string name = scenario.name, uri;
+        int width, height;
+        float fx, fy, cx, cy;
+        if (node["fx"].empty() || node["fy"].empty() || node["cx"].empty() || node["cy"].empty()) {
+            cout << name << ": no intrinsics (fx, fy, cx, cy)" << endl;
+            return false;
+        }
+        node["source"] >> uri;
+        node["width"] >> width;
+        node["height"] >> height;
+        node["fx"] >> fx;
+        node["fy"] >> fy;
+        node["cx"] >> cx;
+        node["cy"] >> cy;
+        Mat K = (Mat_<float>(3, 3) << fx, 0, cx, 0, fy, cy, 0, 0, 1);
+        vector<float> distortion;
+        node["distortion"] >> distortion;
+        
+        FrameSource * source = FrameSource::open(uri, Size(width, height));
+        if (source == NULL) {
+            cout << name << ": could not open " << uri << endl;
+            return false;
+        }
+        Stream * stream = new Stream(name, source, scenario.models, K, scenario.est);
+        if (!distortion.empty()) stream->tracker.distortion = Mat(distortion, true).t();
+        addStream(stream);
+    }
+    
+    return true;
+}
+
+void StreamServer::run() {
+    // Tracks every stream until all of their sources run out
+    
+    // Build any missing template banks first, one at a time, so that streams
+    // sharing a model and camera only ever read the same bank file
+    if (!templateFolder.empty()) {
+        set<string> built;
+        for (int s = 0; s < streams.size(); s++) {
+            Tracker & tracker = streams[s]->tracker;
+            if (!tracker.getEstimates().empty()) continue;
+            for (const Model * model : tracker.getModels()) {
+                string path = TemplateBank::pathFor(templateFolder, model, tracker.getK());
+                if (built.insert(path).second) TemplateBank::loadOrBuild(path, model, tracker.getK());
+            }
+        }
+    }
+    
+    for (int s = 0; s < streams.size(); s++) {
+        Stream * stream = streams[s].get();
+        stream->start = chrono::steady_clock::now();
+        pool.submit([this, stream] {step(stream);});
+    }
+    pool.wait();
+}
+
+void StreamServer::step(Stream * stream) {
+    // Processes one frame of the stream, then queues its next one
+    Mat frame;
+    if (!stream->source->read(frame)) {
+        stream->end = chrono::steady_clock::now();
+        return;
+    }
+    
+    // Live sources know when the frame was captured; otherwise time from now
+    auto start = chrono::steady_clock::now();
+    auto captured = stream->source->getCaptureTime();
+    if (captured == chrono::steady_clock::time_point()) captured = start;
+    
+    if (!stream->initialised) {
+        stream->tracker.initialise(frame, templateFolder);
+        stream->initialised = true;
+    }
+    stream->tracker.processFrame(frame);
+    auto stop = chrono::steady_clock::now();
+    
+    chrono::duration<double> frameTime = stop - captured;
+    stream->latencies.push_back(frameTime.count()*1000.0);
+    
+    pool.submit([this, stream] {step(stream);});
+}
+
+void StreamServer::report() {
+    cout << "Stream          Frames   fps      Mean     p95      Longest (ms)   Dropped" << endl;
+    for (int s = 0; s < streams.size(); s++) {
+        Stream * stream = streams[s].get();
+        vector<double> latencies = stream->latencies;
+        if (latencies.empty()) {
+            printf("%-14s  %6i\n", stream->name.c_str(), 0);
+            continue;
+        }
+        
+        chrono::duration<double> duration = stream->end - stream->start;
+        double mean = 0;
+        for (int i = 0; i < latencies.size(); i++) mean += latencies[i];
+        mean /= latencies.size();
+        sort(latencies.begin(), latencies.end());
+        double p95 = latencies[(latencies.size() - 1) * 95 / 100];
+        
+        printf("%-14s  %6i   %6.1f   %6.2f   %6.2f   %6.2f         %7lli\n", stream->name.c_str(), (int)latencies.size(),
+               latencies.size() / duration.count(), mean, p95, latencies.back(), stream->source->getDropped());
+    }
+}
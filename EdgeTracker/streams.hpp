@@ -0,0 +1,89 @@
+//
+//  streams.hpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#ifndef streams_hpp
+#define streams_hpp
+
+#include <opencv2/core/core.hpp>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <stdio.h>
+
+#include "models.hpp"
+#include "sources.hpp"
+#include "threadpool.hpp"
+#include "tracker.hpp"
+
+using namespace std;
+using namespace cv;
+
+
+// * * * * * * * * * * * * * * *
+//      Stream
+// * * * * * * * * * * * * * * *
+
+class Stream {
+public:
+    Stream(string name_in, FrameSource * source_in, vector<shared_ptr<const Model>> models_in, Mat K, vector<estimate> est = {});
+    string name;
+    unique_ptr<FrameSource> source;
+    vector<shared_ptr<const Model>> models;     // Keeps the (shared) models alive
+    Tracker tracker;
+    vector<double> latencies;                   // Time (ms) from capturing (or else reading) each frame to its poses being ready
+    bool initialised = false;
+    chrono::steady_clock::time_point start, end;
+    
+private:
+    static vector<const Model *> modelPointers(vector<shared_ptr<const Model>> models);
+};
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+//      Tracks many independent streams on a fixed pool of workers.
+//      Each stream has at most one frame in the queue, and goes to
+//      the back of it after every frame, so streams take turns.
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+class StreamServer {
+public:
+    StreamServer(int numWorkers = 0) : pool(numWorkers) {}
+    void addStream(Stream * stream);
+    bool loadConfig(string path);
+    void run();
+    void report();
+    
+public:
+    string templateFolder = "";     // Template banks for streams without starting poses
+    
+private:
+    void step(Stream * stream);
+    
+private:
+    vector<unique_ptr<Stream>> streams;
+    ThreadPool pool;
+};
+
+
+/*
+
+ Config files (FileStorage YAML):
+
+    %YAML:1.0
+    templates: "../templates/"
+    streams:
+       - { name: "cam0", source: "cam0.avi",
+           fx: 1045.8, fy: 1058.8, cx: 646.7, cy: 350.9,
+           models: [ "BlueBox" ],
+           poses: [ [ -28, -28, 640, -0.90, 0.05, -0.11 ] ] }
+       - { name: "cam1", source: "raw:/tmp/cam1", width: 1280, height: 720,
+           fx: 1045.8, fy: 1058.8, cx: 646.7, cy: 350.9,
+           models: [ "Arrow", "Dog" ] }
+
+ */
+
+#endif /* streams_hpp */
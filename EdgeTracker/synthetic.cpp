@@ -0,0 +1,242 @@
+//
+//  synthetic.cpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#include <algorithm>
+#include <numeric>
+
+#include "synthetic.hpp"
+
+
+// * * * * * * * * * * * * * * *
+//      Trajectory
+// * * * * * * * * * * * * * * *
+
+Vec6f Trajectory::poseAt(int frame) const {
+    Vec6f pose;
+    for (int i = 0; i < 6; i++) {
+        pose[i] = start[i] + velocity[i]*frame + amplitude[i]*sin(2*CV_PI*frequency[i]*frame + phase[i]);
+    }
+    return pose;
+}
+
+
+// * * * * * * * * * * * * * * *
+//      SyntheticScene
+// * * * * * * * * * * * * * * *
+
+SyntheticScene::SyntheticScene(Size size_in, Mat K_in, unsigned seed_in) : size(size_in), K(K_in), seed(seed_in) {
+    if (K.empty()) K = intrinsics(size);
+}
+
+Mat SyntheticScene::intrinsics(Size size) {
+    // The calibrated camera, scaled to the given frame size, with the principal point at the centre
+    float f = FOCAL_RATIO * size.width;
+    return (Mat_<float>(3, 3) << f, 0, size.width/2.0, 0, f, size.height/2.0, 0, 0, 1);
+}
+
+SyntheticScene SyntheticScene::random(Size size, int numObjects, vector<string> modelNames, unsigned seed) {
+    SyntheticScene scene = SyntheticScene(size, Mat(), seed);
+    scene.addRandomObjects(numObjects, modelNames);
+    return scene;
+}
+
+void SyntheticScene::addObject(string modelName, Trajectory trajectory) {
+    shared_ptr<const Model> model = Model::byName(modelName);
+    if (!model) {
+        cout << "Unknown model " << modelName << endl;
+        return;
+    }
+    objects.push_back(SceneObject(model, trajectory));
+}
+
+void SyntheticScene::addRandomObjects(int numObjects, vector<string> modelNames) {
+    // Lays the objects out in a grid filling the frame, each sized to fill most of its
+    // cell and wandering about it on a random trajectory.
+    // modelNames: the models to cycle through, default all of the planar ones
+    if (numObjects <= 0) return;
+    if (modelNames.empty()) modelNames = {"Rect", "Dog", "Arrow", "Triangle", "Diamond", "House"};
+    
+    RNG rng(seed + (unsigned)objects.size());
+    int cols = (int)ceil(sqrt(numObjects * size.width / (double)size.height));
+    int rows = (int)ceil(numObjects / (double)cols);
+    float cellWidth = size.width / (float)cols;
+    float cellHeight = size.height / (float)rows;
+    float fx = K.at<float>(0, 0), fy = K.at<float>(1, 1);
+    float cx = K.at<float>(0, 2), cy = K.at<float>(1, 2);
+    
+    for (int i = 0; i < numObjects; i++) {
+        shared_ptr<const Model> model = Model::byName(modelNames[i % modelNames.size()]);
+        if (!model) continue;
+        
+        // The radius of the model about its origin
+        float radius = 0;
+        vector<Point3f> vertices = model->getVertices();
+        for (int v = 0; v < vertices.size(); v++) radius = max(radius, (float)norm(vertices[v]));
+        
+        // Choose the depth so that the model spans 60% of the cell
+        float z = (numObjects == 1) ? DEPTH : fx * 2*radius / (0.6 * min(cellWidth, cellHeight));
+        float u = (i % cols + 0.5) * cellWidth;
+        float v = (i / cols + 0.5) * cellHeight;
+        
+        Trajectory t = Trajectory(Vec6f((u - cx) * z / fx, (v - cy) * z / fy, z, -0.8, 0, 0));
+        t.start[3] += rng.uniform(-0.2, 0.2);
+        t.start[4] += rng.uniform(-0.2, 0.2);
+        t.start[5] += rng.uniform(-0.3, 0.3);
+        t.amplitude = Vec6f(0.15 * cellWidth * z / fx, 0.15 * cellHeight * z / fy, 0.1 * z, 0.2, 0.2, 0.3);
+        for (int p = 0; p < 6; p++) {
+            t.frequency[p] = rng.uniform(0.002, 0.01);
+            t.phase[p] = rng.uniform(0.0, 2*CV_PI);
+        }
+        objects.push_back(SceneObject(model, t));
+    }
+}
+
+bool SyntheticScene::loadConfig(string path) {
+    // Adds the settings and objects described in a scene file (see synthetic.hpp)
+    FileStorage fs(path, FileStorage::READ);
+    if (!fs.isOpened()) {
+        cout << "Could not open " << path << endl;
+        return false;
+    }
+    if (!fs["width"].empty() && !fs["height"].empty()) {
+        size = Size((int)fs["width"], (int)fs["height"]);
+        K = intrinsics(size);
+    }
+    if (!fs["seed"].empty())        seed = (int)fs["seed"];
+    if (!fs["noise"].empty())       noise = (double)fs["noise"];
+    if (!fs["blur"].empty())        blur = (double)fs["blur"];
+    if (!fs["clutter"].empty())     clutter = (int)fs["clutter"];
+    if (!fs["occluders"].empty())   occluders = (int)fs["occluders"];
+    
+    FileNode list = fs["objects"];
+    for (FileNodeIterator it = list.begin(); it != list.end(); ++it) {
+        FileNode node = *it;
+        string modelName;
+        node["model"] >> modelName;
+        
+        Trajectory t;
+        vector<string> keys = {"start", "velocity", "amplitude", "frequency", "phase"};
+        vector<Vec6f *> values = {&t.start, &t.velocity, &t.amplitude, &t.frequency, &t.phase};
+        for (int k = 0; k < keys.size(); k++) {
+            vector<float> v;
+            node[keys[k]] >> v;
+            if (v.size() == 6) *values[k] = Vec6f(v[0], v[1], v[2], v[3], v[4], v[5]);
+        }
+        addObject(modelName, t);
+    }
+    
+    if (!fs["random"].empty()) addRandomObjects((int)fs["random"]);
+    
+    backdrop = Mat();
+    return true;
+}
+
+void SyntheticScene::setSize(Size size_in) {
+    // Renders at a new frame size, with the calibrated camera scaled to match
+    size = size_in;
+    K = intrinsics(size);
+    backdrop = Mat();
+}
+
+vector<Vec6f> SyntheticScene::posesAt(int frame) const {
+    vector<Vec6f> poses;
+    for (int i = 0; i < objects.size(); i++) poses.push_back(objects[i].trajectory.poseAt(frame));
+    return poses;
+}
+
+vector<const Model *> SyntheticScene::getModels() const {
+    vector<const Model *> ret;
+    for (int i = 0; i < objects.size(); i++) ret.push_back(objects[i].model.get());
+    return ret;
+}
+
+vector<shared_ptr<const Model>> SyntheticScene::getSharedModels() const {
+    vector<shared_ptr<const Model>> ret;
+    for (int i = 0; i < objects.size(); i++) ret.push_back(objects[i].model);
+    return ret;
+}
+
+
+// * * * * * * * * * * * * * * *
+//      Rendering
+// * * * * * * * * * * * * * * *
+
+void SyntheticScene::createClutter() {
+    // Draws the static distractors into the backdrop and picks the occluders.
+    // Both depend only on the seed, so every frame of a scene matches.
+    RNG rng(seed);
+    backdrop = Mat(size, CV_8UC3, background);
+    
+    int scale = max(size.width, size.height) / 20;
+    for (int i = 0; i < clutter; i++) {
+        Scalar colour = Scalar(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256));
+        Point p = Point(rng.uniform(0, size.width), rng.uniform(0, size.height));
+        switch (rng.uniform(0, 3)) {
+            case 0:
+                line(backdrop, p, p + Point(rng.uniform(-4*scale, 4*scale), rng.uniform(-4*scale, 4*scale)), colour, rng.uniform(1, 4));
+                break;
+            case 1:
+                circle(backdrop, p, rng.uniform(scale/4, scale), colour, -1);
+                break;
+            default: {
+                vector<Point> polygon;
+                for (int v = 0; v < 4; v++) polygon.push_back(p + Point(rng.uniform(-scale, scale), rng.uniform(-scale, scale)));
+                fillConvexPoly(backdrop, polygon, colour);
+            }
+        }
+    }
+    
+    occluderShapes.clear();
+    occluderCentres.clear();
+    occluderColours.clear();
+    occluderVelocities.clear();
+    for (int i = 0; i < occluders; i++) {
+        // A bar, like an arm or a pole, drifting across the frame
+        Point along = Point(rng.uniform(-2*scale, 2*scale), rng.uniform(-2*scale, 2*scale));
+        Point across = Point(-along.y, along.x) / 6;
+        occluderShapes.push_back({-along - across, along - across, along + across, -along + across});
+        occluderCentres.push_back(Point2f(rng.uniform(0, size.width), rng.uniform(0, size.height)));
+        occluderColours.push_back(Scalar(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256)));
+        occluderVelocities.push_back(Point2f(rng.uniform(-4.0, 4.0), rng.uniform(-4.0, 4.0)) * (size.width / 1280.0));
+    }
+}
+
+void SyntheticScene::render(int frame, Mat & img, vector<Vec6f> & poses) {
+    // Renders the given frame of the scene, with the true pose of every object.
+    // The same frame number always gives the same image.
+    if (backdrop.empty()) createClutter();
+    backdrop.copyTo(img);
+    poses = posesAt(frame);
+    
+    // Draw the objects from back to front
+    vector<int> order(objects.size());
+    iota(order.begin(), order.end(), 0);
+    sort(order.begin(), order.end(), [&](int a, int b) {return poses[a][2] > poses[b][2];});
+    for (int i : order) {
+        objects[i].model->draw(img, poses[i], K, false, objects[i].model->colour);
+    }
+    
+    // Occluders drift across the frame, wrapping around its edges
+    for (int i = 0; i < occluderShapes.size(); i++) {
+        Point2f centre = occluderCentres[i] + occluderVelocities[i] * frame;
+        centre.x -= floor(centre.x / size.width) * size.width;
+        centre.y -= floor(centre.y / size.height) * size.height;
+        vector<Point> shape = occluderShapes[i];
+        for (int v = 0; v < shape.size(); v++) shape[v] += Point(centre);
+        fillConvexPoly(img, shape, occluderColours[i]);
+    }
+    
+    if (blur > 0) GaussianBlur(img, img, Size(0, 0), blur);
+    
+    if (noise > 0) {
+        RNG rng(seed * 7919 + frame);
+        Mat n = Mat(size, CV_16SC3);
+        rng.fill(n, RNG::NORMAL, Scalar::all(0), Scalar::all(noise));
+        add(img, n, img, noArray(), CV_8UC3);
+    }
+}
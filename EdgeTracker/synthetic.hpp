@@ -0,0 +1,129 @@
+//
+//  synthetic.hpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#ifndef synthetic_hpp
+#define synthetic_hpp
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <iostream>
+#include <memory>
+#include <stdio.h>
+
+#include "models.hpp"
+
+using namespace std;
+using namespace cv;
+
+
+// * * * * * * * * * * * * * * *
+//      Trajectory
+// * * * * * * * * * * * * * * *
+
+class Trajectory {
+public:
+    Trajectory(Vec6f start_in = Vec6f()) : start(start_in) {}
+    Vec6f poseAt(int frame) const;
+    
+public:
+    // Each pose parameter follows
+    //    start + velocity*f + amplitude*sin(2*PI*frequency*f + phase)
+    // for frame f. Translations in mm, rotations in radians, frequencies in cycles per frame.
+    Vec6f start, velocity, amplitude, frequency, phase;
+};
+
+
+// * * * * * * * * * * * * * * *
+//      SceneObject
+// * * * * * * * * * * * * * * *
+
+class SceneObject {
+public:
+    SceneObject(shared_ptr<const Model> model_in, Trajectory trajectory_in) : model(model_in), trajectory(trajectory_in) {}
+    shared_ptr<const Model> model;
+    Trajectory trajectory;
+};
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+//      Renders the known models along known trajectories, giving
+//      frames with exact ground-truth poses for offline evaluation
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+class SyntheticScene {
+    
+/*
+ METHODS
+ */
+public:
+    SyntheticScene(Size size_in, Mat K_in = Mat(), unsigned seed_in = 1);
+    static Mat intrinsics(Size size);
+    static SyntheticScene random(Size size, int numObjects, vector<string> modelNames = {}, unsigned seed = 1);
+    bool loadConfig(string path);
+    void setSize(Size size_in);
+    void addObject(string modelName, Trajectory trajectory);
+    void addRandomObjects(int numObjects, vector<string> modelNames = {});
+    void render(int frame, Mat & img, vector<Vec6f> & poses);
+    vector<Vec6f> posesAt(int frame) const;
+    vector<const Model *> getModels() const;
+    vector<shared_ptr<const Model>> getSharedModels() const;
+    Mat getK() const {return K;}
+    Size getSize() const {return size;}
+    
+private:
+    void createClutter();
+    
+public:
+    Scalar background = Scalar(200, 200, 200);
+    int clutter = 0;        // No. of static distractor shapes behind the objects
+    int occluders = 0;      // No. of moving shapes in front of the objects
+    double noise = 0;       // Std. dev. of the Gaussian pixel noise
+    double blur = 0;        // Std. dev. of the Gaussian (defocus) blur, in pixels
+    
+private:
+    Size size;
+    Mat K;
+    unsigned seed;
+    vector<SceneObject> objects;
+    Mat backdrop;           // The background with its clutter, drawn once
+    vector<vector<Point>> occluderShapes;     // Relative to their centres
+    vector<Point2f> occluderCentres;
+    vector<Scalar> occluderColours;
+    vector<Point2f> occluderVelocities;
+    
+/*
+ CONSTANTS
+ */
+public:
+    static constexpr float FOCAL_RATIO = 0.817;     // Focal length / frame width of the calibrated camera
+    static constexpr float DEPTH = 400;             // Depth of the objects (mm) if there is only one
+    
+};
+
+
+/*
+
+ Scene files (FileStorage YAML):
+
+    %YAML:1.0
+    width: 1920
+    height: 1080
+    seed: 7
+    noise: 4
+    blur: 0.8
+    clutter: 30
+    occluders: 2
+    objects:
+       - { model: "Dog", start: [ 0, 0, 400, -0.8, 0.1, 0.05 ],
+           velocity: [ 0.5, 0, 0, 0, 0, 0 ],
+           amplitude: [ 60, 40, 30, 0.2, 0.2, 0.3 ],
+           frequency: [ 0.01, 0.007, 0.003, 0.005, 0.004, 0.006 ] }
+    random: 20          # Add 20 more objects on random trajectories
+
+ */
+
+#endif /* synthetic_hpp */
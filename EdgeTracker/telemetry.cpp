@@ -0,0 +1,173 @@
+//
+//  telemetry.cpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#include <chrono>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "telemetry.hpp"
+#include "tracker.hpp"
+
+static const char MAGIC[8] = "ETTELE1";
+
+const char * TelemetryPublisher::DEFAULT_NAME = "/edgetracker";
+
+static_assert(sizeof(TelemetryHeader) == 64, "TelemetryHeader must fill one cache line");
+static_assert(sizeof(TelemetrySlot) == 128, "TelemetrySlot must fill two cache lines");
+
+
+// * * * * * * * * * * * * * * *
+//      Publishing
+// * * * * * * * * * * * * * * *
+
+bool TelemetryPublisher::open(string name_in, int capacity) {
+    // Creates (or replaces) the shared memory object 'name'
+    close();
+    if (capacity <= 0 || (capacity & (capacity - 1)) != 0) return false;
+    name = name_in;
+    length = sizeof(TelemetryHeader) + capacity * sizeof(TelemetrySlot);
+    
+    // Start from a fresh object, so readers of an old one see it end
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd < 0) return false;
+    void * mapping = MAP_FAILED;
+    if (ftruncate(fd, length) == 0) mapping = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        shm_unlink(name.c_str());
+        return false;
+    }
+    
+    // The new object is zeroed: every slot's version is 0 (empty)
+    header = (TelemetryHeader *)mapping;
+    slots = (TelemetrySlot *)((char *)mapping + sizeof(TelemetryHeader));
+    header->capacity = capacity;
+    header->slotSize = sizeof(TelemetrySlot);
+    header->head.store(0, memory_order_relaxed);
+    header->publishing.store(1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    memcpy(header->magic, MAGIC, sizeof(MAGIC));
+    return true;
+}
+
+void TelemetryPublisher::close() {
+    // Readers already attached keep their mapping, and see that it has ended
+    if (header == NULL) return;
+    header->publishing.store(0, memory_order_release);
+    munmap(header, length);
+    shm_unlink(name.c_str());
+    header = NULL;
+    slots = NULL;
+}
+
+void TelemetryPublisher::publish(int frame, int model, const estimate & est, double errorArea, double time, const FrameStats & stats, double latency) {
+    // Called from the tracking thread only
+    if (header == NULL) return;
+    uint64_t n = header->head.load(memory_order_relaxed);
+    TelemetrySlot & slot = slots[n & (header->capacity - 1)];
+    
+    slot.version.store(2*n + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    
+    TelemetryRecord & r = slot.record;
+    r.sequence = n;
+    r.timestamp = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+    r.frame = frame;
+    r.model = model;
+    for (int i = 0; i < 6; i++) r.pose[i] = est.pose[i];
+    r.errorArea = errorArea;
+    r.errorLsq = est.error;
+    r.iterations = est.iterations;
+    r.time = time;
+    r.preprocessTime = stats.preprocessTime;
+    r.trackTime = stats.trackTime;
+    r.latency = latency;
+    r.whiskers = stats.whiskers;
+    r.projections = stats.iterations;
+    r.skipped = stats.skipped;
+    
+    slot.version.store(2*n + 2, memory_order_release);
+    header->head.store(n + 1, memory_order_release);
+}
+
+
+// * * * * * * * * * * * * * * *
+//      Reading
+// * * * * * * * * * * * * * * *
+
+bool TelemetryReader::open(string name) {
+    // Attaches to a publisher's shared memory object, at its oldest record
+    close();
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) return false;
+    struct stat st;
+    void * mapping = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(TelemetryHeader)) {
+        length = st.st_size;
+        mapping = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (mapping == MAP_FAILED) return false;
+    
+    // The magic is written last, so once it is there the rest of the header is too
+    header = (TelemetryHeader *)mapping;
+    slots = (TelemetrySlot *)((char *)mapping + sizeof(TelemetryHeader));
+    bool valid = memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0;
+    atomic_thread_fence(memory_order_acquire);
+    int capacity = header->capacity;
+    if (!valid || header->slotSize != sizeof(TelemetrySlot) || capacity <= 0 || (capacity & (capacity - 1)) != 0 ||
+        length < sizeof(TelemetryHeader) + capacity * sizeof(TelemetrySlot)) {
+        close();
+        return false;
+    }
+    
+    uint64_t head = header->head.load(memory_order_acquire);
+    nextSequence = (head > (uint64_t)capacity) ? head - capacity : 0;
+    lost = 0;
+    return true;
+}
+
+void TelemetryReader::close() {
+    if (header == NULL) return;
+    munmap(header, length);
+    header = NULL;
+    slots = NULL;
+}
+
+bool TelemetryReader::next(TelemetryRecord & record) {
+    // Copies out the next record, if it has been published. Records overwritten
+    // before they could be read are skipped, and counted as lost.
+    uint64_t capacity = header->capacity;
+    while (true) {
+        uint64_t head = header->head.load(memory_order_acquire);
+        if (nextSequence >= head) return false;
+        if (head - nextSequence > capacity) {
+            lost += head - capacity - nextSequence;
+            nextSequence = head - capacity;
+        }
+        
+        const TelemetrySlot & slot = slots[nextSequence & (capacity - 1)];
+        uint64_t version = slot.version.load(memory_order_acquire);
+        if (version == 2*nextSequence + 2) {
+            memcpy(&record, &slot.record, sizeof(TelemetryRecord));
+            atomic_thread_fence(memory_order_acquire);
+            if (slot.version.load(memory_order_relaxed) == version) {
+                nextSequence++;
+                return true;
+            }
+        }
+        
+        // Overwritten by a later record (before or while copying it)
+        lost++;
+        nextSequence++;
+    }
+}
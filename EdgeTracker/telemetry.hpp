@@ -0,0 +1,141 @@
+//
+//  telemetry.hpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#ifndef telemetry_hpp
+#define telemetry_hpp
+
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "lsq.hpp"
+
+using namespace std;
+
+class FrameStats;
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2, "Telemetry needs lock-free atomics to share them between processes");
+
+
+// * * * * * * * * * * * * * * *
+//      TelemetryRecord
+// * * * * * * * * * * * * * * *
+
+struct TelemetryRecord {
+    uint64_t sequence;      // Place in the stream, from 0
+    int64_t timestamp;      // When published: steady clock (ns), the same in every process
+    int32_t frame;
+    int32_t model;
+    float pose[6];          // x, y, z, rx, ry, rz
+    float errorArea;        // NAN if not measured this frame
+    float errorLsq;
+    float iterations;       // Solver iterations of the model's estimate
+    float time;             // Frame processing time (ms)
+    float preprocessTime;   // Edge detection (ms)
+    float trackTime;        // Whisker search and pose solving, all models (ms)
+    float latency;          // Capture to pose (ms), NAN if not known
+    int32_t whiskers;       // Whiskers searched this frame, all models
+    int32_t projections;    // Whisker projections this frame, all models
+    int32_t skipped;        // Models left unrefined for the frame budget
+};
+
+struct TelemetryHeader {
+    char magic[8];                  // "ETTELE1"
+    int32_t capacity;               // No. of slots (a power of two)
+    int32_t slotSize;               // Bytes per slot
+    atomic<uint64_t> head;          // No. of records published so far
+    atomic<int32_t> publishing;     // 1 until the publisher closes
+    char pad[64 - 8 - 2*sizeof(int32_t) - sizeof(atomic<uint64_t>) - sizeof(atomic<int32_t>)];
+};
+
+struct TelemetrySlot {
+    atomic<uint64_t> version;       // Odd while record n is being written (2n+1), then 2n+2
+    TelemetryRecord record;
+    char pad[128 - sizeof(atomic<uint64_t>) - sizeof(TelemetryRecord)];
+};
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+//      Publishes one record per model per frame to a ring in shared
+//      memory, for other processes on the machine to read as soon as
+//      it is written. The publisher never waits for its readers: each
+//      slot is guarded by a sequence lock, and a reader that falls
+//      more than a ring behind loses the records it missed.
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+class TelemetryPublisher {
+    
+/*
+ METHODS
+ */
+public:
+    TelemetryPublisher() {}
+    ~TelemetryPublisher() {close();}
+    bool open(string name = DEFAULT_NAME, int capacity = DEFAULT_CAPACITY);
+    void close();
+    bool isOpen() const {return header != NULL;}
+    void publish(int frame, int model, const estimate & est, double errorArea, double time, const FrameStats & stats, double latency = NAN);
+    
+private:
+    string name;
+    TelemetryHeader * header = NULL;
+    TelemetrySlot * slots = NULL;
+    size_t length = 0;
+    
+/*
+ CONSTANTS
+ */
+public:
+    static const char * DEFAULT_NAME;           // The shared memory object ("/edgetracker")
+    static const int DEFAULT_CAPACITY = 4096;   // Records kept (a power of two)
+    
+};
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+//      Reads the records of a TelemetryPublisher, in order, straight
+//      from the shared ring. Reads never block or write to the ring,
+//      so any number of readers may follow one publisher.
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+class TelemetryReader {
+public:
+    TelemetryReader() {}
+    ~TelemetryReader() {close();}
+    bool open(string name = TelemetryPublisher::DEFAULT_NAME);
+    void close();
+    bool isOpen() const {return header != NULL;}
+    bool next(TelemetryRecord & record);
+    void skipToEnd() {nextSequence = header->head.load(memory_order_acquire);}
+    bool ended() const {return header->publishing.load(memory_order_acquire) == 0 && nextSequence >= header->head.load(memory_order_acquire);}
+    long long getLost() const {return lost;}
+    
+private:
+    TelemetryHeader * header = NULL;
+    TelemetrySlot * slots = NULL;
+    size_t length = 0;
+    uint64_t nextSequence = 0;
+    long long lost = 0;
+};
+
+
+/*
+
+ Shared memory layout (POSIX shared memory object, native byte order):
+
+    TelemetryHeader     64 bytes
+    TelemetrySlot       x capacity, 128 bytes each
+
+ Record n is in slot n % capacity. The publisher sets the slot's version to
+ 2n+1, writes the record, sets the version to 2n+2 and then head to n+1.
+ A reader copies the record between two reads of the version, and keeps it
+ only if both were 2n+2: otherwise it was overwritten while being read.
+
+ */
+
+#endif /* telemetry_hpp */
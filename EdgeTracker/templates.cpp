@@ -0,0 +1,306 @@
+//
+//  templates.cpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#include <algorithm>
+#include <climits>
+
+#include "templates.hpp"
+#include "orange.hpp"
+
+const float TemplateBank::ORIENTATION_WEIGHT = 10;
+
+
+// * * * * * * * * * * * * * * *
+//      Building
+// * * * * * * * * * * * * * * *
+
+TemplateBank TemplateBank::build(const Model * model, Mat K, int rotSteps) {
+    // Renders the model's silhouette at every rotation in a grid of 'rotSteps'
+    // steps per revolution and stores a descriptor of each.
+    TemplateBank bank;
+    bank.fx = K.at<float>(0, 0);
+    bank.fy = K.at<float>(1, 1);
+    
+    // Render onto a small canvas, with the principal point at its centre
+    Mat Kt = K.clone();
+    Kt.at<float>(0, 2) = CANVAS_SIZE/2;
+    Kt.at<float>(1, 2) = CANVAS_SIZE/2;
+    
+    // Choose a depth at which the whole model spans about half the canvas
+    float radius = 0;
+    vector<Point3f> vertices = model->getVertices();
+    for (int i = 0; i < vertices.size(); i++) radius = MAX(radius, (float)norm(vertices[i]));
+    bank.depth = 4 * radius * bank.fx / CANVAS_SIZE;
+    
+    bank.descriptors = Mat(0, DESCRIPTOR_SIZE, CV_32FC1);
+    double step = CV_2PI / rotSteps;
+    
+    for (int x = 0; x < rotSteps; x++) {
+        for (int y = 0; y <= rotSteps/2; y++) {
+            for (int z = 0; z < rotSteps; z++) {
+                Vec6f pose = {0, 0, bank.depth, float(-CV_PI + x*step), float(-CV_PI/2 + y*step), float(-CV_PI + z*step)};
+                
+                Mat canvas = Mat::zeros(CANVAS_SIZE, CANVAS_SIZE, CV_8UC1);
+                model->draw(canvas, pose, Kt, false, Scalar(255));
+                threshold(canvas, canvas, 0, 255, THRESH_BINARY);
+                
+                // Skip views where the model is (nearly) edge-on
+                vector<Point> contour;
+                Mat desc = descriptor(canvas, contour);
+                if (contour.empty()) continue;
+                
+                Moments mm = moments(contour);
+                ViewTemplate t;
+                t.pose = pose;
+                t.area = mm.m00;
+                t.centroid = Point2f(mm.m10/mm.m00, mm.m01/mm.m00);
+                t.descriptor = desc;
+                t.edges = sampleEdges(contour, t.centroid, t.area);
+                
+                bank.templates.push_back(t);
+                bank.descriptors.push_back(desc);
+            }
+        }
+    }
+    
+    return bank;
+}
+
+TemplateBank TemplateBank::loadOrBuild(string path, const Model * model, Mat K) {
+    // Loads the bank from 'path', or builds (and saves) it if it does not exist
+    // or was rendered with different intrinsics.
+    TemplateBank bank;
+    if (bank.load(path) && bank.matchesIntrinsics(K)) return bank;
+    
+    bank = build(model, K);
+    if (!bank.save(path)) cout << "Could not save the template bank to " << path << endl;
+    return bank;
+}
+
+string TemplateBank::pathFor(string folder, const Model * model, Mat K) {
+    // The bank file for a model seen through K: one per model and focal length,
+    // so that cameras with different intrinsics never overwrite each other's
+    int fx = cvRound(K.at<float>(0, 0));
+    int fy = cvRound(K.at<float>(1, 1));
+    return folder + model->name + "_" + to_string(fx) + "x" + to_string(fy) + ".yml.gz";
+}
+
+bool TemplateBank::matchesIntrinsics(Mat K) {
+    return abs(fx - K.at<float>(0, 0)) < 0.5 && abs(fy - K.at<float>(1, 1)) < 0.5;
+}
+
+
+// * * * * * * * * * * * * * * *
+//      Serialisation
+// * * * * * * * * * * * * * * *
+
+bool TemplateBank::save(string path) {
+    FileStorage fs(path, FileStorage::WRITE);
+    if (!fs.isOpened()) return false;
+    
+    fs << "depth" << depth << "fx" << fx << "fy" << fy;
+    fs << "templates" << "[";
+    for (int i = 0; i < templates.size(); i++) {
+        ViewTemplate & t = templates[i];
+        fs << "{";
+        fs << "pose" << vector<float>(t.pose.val, t.pose.val + 6);
+        fs << "centroid" << t.centroid;
+        fs << "area" << t.area;
+        fs << "descriptor" << t.descriptor;
+        fs << "edges" << t.edges;
+        fs << "}";
+    }
+    fs << "]";
+    
+    fs.release();
+    return true;
+}
+
+bool TemplateBank::load(string path) {
+    FileStorage fs(path, FileStorage::READ);
+    if (!fs.isOpened()) return false;
+    
+    fs["depth"] >> depth;
+    fs["fx"] >> fx;
+    fs["fy"] >> fy;
+    
+    templates.clear();
+    descriptors = Mat(0, DESCRIPTOR_SIZE, CV_32FC1);
+    
+    FileNode list = fs["templates"];
+    for (FileNodeIterator it = list.begin(); it != list.end(); ++it) {
+        ViewTemplate t;
+        vector<float> pose;
+        (*it)["pose"] >> pose;
+        if (pose.size() != 6) return false;
+        t.pose = Vec6f(pose[0], pose[1], pose[2], pose[3], pose[4], pose[5]);
+        (*it)["centroid"] >> t.centroid;
+        (*it)["area"] >> t.area;
+        (*it)["descriptor"] >> t.descriptor;
+        (*it)["edges"] >> t.edges;
+        
+        templates.push_back(t);
+        descriptors.push_back(t.descriptor);
+    }
+    
+    return !templates.empty();
+}
+
+
+// * * * * * * * * * * * * * * *
+//      Matching
+// * * * * * * * * * * * * * * *
+
+bool TemplateBank::match(Mat mask, Mat K, Vec6f & pose) {
+    // Finds the template that best explains the binary 'mask' and recovers the
+    // full pose from it. Returns false if there is no blob of at least MIN_AREA,
+    // or if no template's edges fit it to within MAX_MATCH_ERROR.
+    vector<Point> contour;
+    Mat query = descriptor(mask, contour);
+    if (contour.empty() || templates.empty()) return false;
+    
+    Moments mm = moments(contour);
+    double area = mm.m00;
+    Point2f centroid = Point2f(mm.m10/mm.m00, mm.m01/mm.m00);
+    
+    // Shortlist the templates with the closest descriptors
+    vector<pair<float, int>> ranked;
+    for (int i = 0; i < descriptors.rows; i++) {
+        ranked.push_back(make_pair((float)norm(descriptors.row(i), query, NORM_L1), i));
+    }
+    int numCandidates = MIN(CANDIDATES, (int)ranked.size());
+    partial_sort(ranked.begin(), ranked.begin() + numCandidates, ranked.end());
+    
+    // Verify the shortlist against the distance to the observed silhouette edge,
+    // only computed in the region around the object
+    Rect roi = boundingRect(contour);
+    roi -= Point(int(MAX_CHAMFER), int(MAX_CHAMFER));
+    roi += Size(int(2*MAX_CHAMFER), int(2*MAX_CHAMFER));
+    roi &= Rect(0, 0, mask.cols, mask.rows);
+    
+    Mat outline = Mat(roi.size(), CV_8UC1, Scalar(255));
+    vector<vector<Point>> contours = {contour};
+    drawContours(outline, contours, 0, Scalar(0), 1, LINE_8, noArray(), INT_MAX, -roi.tl());
+    Mat dist;
+    distanceTransform(outline, dist, DIST_L2, 3);
+    
+    Point2f centroidRoi = centroid - Point2f(roi.tl());
+    int best = -1;
+    float bestDist = MAX_CHAMFER;
+    for (int c = 0; c < numCandidates; c++) {
+        int i = ranked[c].second;
+        float d = chamferDistance(templates[i].edges, dist, centroidRoi, area);
+        if (d < bestDist) {
+            bestDist = d;
+            best = i;
+        }
+    }
+    if (best < 0 || bestDist > MAX_MATCH_ERROR * sqrt(area)) return false;
+    
+    // Estimate the depth from the ratio of the template and measured areas, then
+    // find x & y from the offset of the centroid relative to the template's
+    // (which was rendered with the principal point at the centre of the canvas).
+    ViewTemplate & t = templates[best];
+    float z = depth * sqrt(t.area / area);
+    pose = t.pose;
+    pose[0] = z * ((centroid.x - K.at<float>(0, 2)) - (t.centroid.x - CANVAS_SIZE/2)) / K.at<float>(0, 0);
+    pose[1] = z * ((centroid.y - K.at<float>(1, 2)) - (t.centroid.y - CANVAS_SIZE/2)) / K.at<float>(1, 1);
+    pose[2] = z;
+    
+    return true;
+}
+
+bool TemplateBank::initialPose(Mat frame, const Model * model, Mat K, Vec6f & pose) {
+    // Segments the model's colour from the frame and matches the result
+    Mat seg = orange::segmentByColour(frame, model->colour);
+    cvtColor(seg, seg, CV_BGR2GRAY);
+    threshold(seg, seg, 0, 255, CV_THRESH_BINARY);
+    return match(seg, K, pose);
+}
+
+
+// * * * * * * * * * * * * * * *
+//      Descriptors
+// * * * * * * * * * * * * * * *
+
+Mat TemplateBank::descriptor(Mat mask, vector<Point> & contour) {
+    // Describes the largest blob in a binary mask by its Hu moments and a coarse
+    // histogram of its edge orientations. 'contour' is set to the blob's outline
+    // (empty if there is no blob large enough).
+    Mat desc = Mat::zeros(1, DESCRIPTOR_SIZE, CV_32FC1);
+    contour.clear();
+    
+    vector<vector<Point>> contours;
+    findContours(mask.clone(), contours, RETR_EXTERNAL, CHAIN_APPROX_NONE);
+    double largest = MIN_AREA;
+    for (int i = 0; i < contours.size(); i++) {
+        double a = contourArea(contours[i]);
+        if (a >= largest) {
+            largest = a;
+            contour = contours[i];
+        }
+    }
+    if (contour.empty()) return desc;
+    
+    // Hu moments, log-scaled so they have comparable magnitudes
+    double hu[7];
+    HuMoments(moments(contour), hu);
+    for (int i = 0; i < 7; i++) {
+        if (abs(hu[i]) > 1e-30) desc.at<float>(i) = -copysign(1.0, hu[i]) * log10(abs(hu[i]));
+    }
+    
+    // Histogram of the edge directions (mod PI), weighted by length and softly binned
+    float * hist = desc.ptr<float>(0) + 7;
+    int n = (int)contour.size();
+    float total = 0;
+    for (int i = 0; i < n; i += ORIENTATION_STRIDE) {
+        Point d = contour[(i + ORIENTATION_STRIDE) % n] - contour[i];
+        float length = sqrt(float(d.dot(d)));
+        if (length == 0) continue;
+        
+        float angle = atan2(float(d.y), float(d.x));
+        if (angle < 0) angle += CV_PI;
+        float bin = angle / CV_PI * ORIENTATION_BINS - 0.5;
+        int b0 = floor(bin);
+        float f = bin - b0;
+        hist[(b0 + ORIENTATION_BINS) % ORIENTATION_BINS] += (1 - f) * length;
+        hist[(b0 + 1) % ORIENTATION_BINS] += f * length;
+        total += length;
+    }
+    if (total > 0) {
+        for (int b = 0; b < ORIENTATION_BINS; b++) hist[b] *= ORIENTATION_WEIGHT / total;
+    }
+    
+    return desc;
+}
+
+Mat TemplateBank::sampleEdges(vector<Point> contour, Point2f centroid, double area) {
+    // Samples points evenly along the contour, normalised for position and scale
+    Mat edges = Mat(EDGE_SAMPLES, 2, CV_32FC1);
+    float scale = 1.0 / sqrt(area);
+    for (int i = 0; i < EDGE_SAMPLES; i++) {
+        Point p = contour[i * contour.size() / EDGE_SAMPLES];
+        edges.at<float>(i, 0) = (p.x - centroid.x) * scale;
+        edges.at<float>(i, 1) = (p.y - centroid.y) * scale;
+    }
+    return edges;
+}
+
+float TemplateBank::chamferDistance(Mat edges, Mat dist, Point2f centroid, double area) {
+    // Mean (truncated) distance from the template's edge samples, placed at the
+    // given centroid and area, to the nearest observed edge
+    float scale = sqrt(area);
+    float sum = 0;
+    for (int i = 0; i < edges.rows; i++) {
+        int x = cvRound(centroid.x + edges.at<float>(i, 0) * scale);
+        int y = cvRound(centroid.y + edges.at<float>(i, 1) * scale);
+        if (x < 0 || y < 0 || x >= dist.cols || y >= dist.rows) sum += MAX_CHAMFER;
+        else sum += MIN(dist.at<float>(y, x), MAX_CHAMFER);
+    }
+    return sum / edges.rows;
+}
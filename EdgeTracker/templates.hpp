@@ -0,0 +1,87 @@
+//
+//  templates.hpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#ifndef templates_hpp
+#define templates_hpp
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <iostream>
+#include <stdio.h>
+
+#include "lsq.hpp"
+#include "models.hpp"
+
+using namespace std;
+using namespace cv;
+
+
+// * * * * * * * * * * * * * * *
+//      ViewTemplate
+// * * * * * * * * * * * * * * *
+
+class ViewTemplate {
+public:
+    Vec6f pose;         // The pose the model was rendered at (x = y = 0)
+    Point2f centroid;   // Centroid of the rendered silhouette
+    double area;        // Area of the rendered silhouette (pixels)
+    Mat descriptor;     // 1 x DESCRIPTOR_SIZE shape descriptor
+    Mat edges;          // EDGE_SAMPLES x 2 silhouette edge points, relative to the centroid and scaled by 1/sqrt(area)
+};
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+//      A bank of silhouettes rendered at discretised rotations,
+//      used to find a starting pose for a model from a single frame
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+class TemplateBank {
+    
+/*
+ METHODS
+ */
+public:
+    TemplateBank() : depth(0), fx(0), fy(0) {}
+    static TemplateBank build(const Model * model, Mat K, int rotSteps = ROTATION_STEPS);
+    static TemplateBank loadOrBuild(string path, const Model * model, Mat K);
+    static string pathFor(string folder, const Model * model, Mat K);
+    bool save(string path);
+    bool load(string path);
+    bool empty() {return templates.empty();}
+    bool match(Mat mask, Mat K, Vec6f & pose);
+    bool initialPose(Mat frame, const Model * model, Mat K, Vec6f & pose);
+    static Mat descriptor(Mat mask, vector<Point> & contour);
+    
+private:
+    static Mat sampleEdges(vector<Point> contour, Point2f centroid, double area);
+    static float chamferDistance(Mat edges, Mat dist, Point2f centroid, double area);
+    bool matchesIntrinsics(Mat K);
+    
+private:
+    vector<ViewTemplate> templates;
+    Mat descriptors;    // All template descriptors, one per row
+    float depth;        // The depth at which the templates were rendered
+    float fx, fy;       // The focal lengths the templates were rendered with
+    
+/*
+ CONSTANTS
+ */
+public:
+    static const int ROTATION_STEPS = 12;   // Steps per full revolution (i.e. 30 degrees)
+    static const int CANVAS_SIZE = 320;
+    static const int DESCRIPTOR_SIZE = 15;  // 7 Hu moments + 8 orientation bins
+    static const int ORIENTATION_BINS = 8;
+    static const int ORIENTATION_STRIDE = 5;    // Contour step (pixels) used to measure edge directions
+    static const int EDGE_SAMPLES = 64;
+    static const int CANDIDATES = 5;        // No. of descriptor matches verified against the edges
+    static const int MIN_AREA = 50;         // Smallest silhouette (pixels) worth describing
+    static constexpr float MAX_CHAMFER = 20;
+    static constexpr float MAX_MATCH_ERROR = 0.15;  // Largest mean edge distance of a match, relative to the blob's size (sqrt of its area)
+    static const float ORIENTATION_WEIGHT;
+};
+
+#endif /* templates_hpp */
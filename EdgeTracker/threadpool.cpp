@@ -0,0 +1,111 @@
+//
+//  threadpool.cpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#include "threadpool.hpp"
+
+
+ThreadPool::ThreadPool(int numThreads) {
+    // numThreads: no. of workers, one per core if 0
+    if (numThreads <= 0) numThreads = max(1u, thread::hardware_concurrency());
+    for (int i = 0; i < numThreads; i++) {
+        workers.push_back(thread(&ThreadPool::work, this));
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    // Finish the queued tasks, then stop the workers
+    {
+        unique_lock<mutex> guard(lock);
+        stopping = true;
+    }
+    taskAdded.notify_all();
+    for (int i = 0; i < workers.size(); i++) workers[i].join();
+}
+
+void ThreadPool::submit(function<void()> task) {
+    {
+        unique_lock<mutex> guard(lock);
+        tasks.push(task);
+    }
+    taskAdded.notify_one();
+}
+
+void ThreadPool::wait() {
+    // Blocks until the queue is empty and no task is running. Tasks may submit
+    // further tasks, which are waited for too.
+    unique_lock<mutex> guard(lock);
+    taskDone.wait(guard, [this] {return tasks.empty() && busy == 0;});
+}
+
+void ThreadPool::parallelFor(int n, int chunk, function<void(int, int)> body) {
+    // Runs body(begin, end) over [0, n) in chunks of the given size, and returns once
+    // every chunk is done. Chunks are claimed by the caller and by any workers that are
+    // free; if none are, the caller does them all, so this never deadlocks.
+    if (n <= 0) return;
+    chunk = max(chunk, 1);
+    int numChunks = (n + chunk - 1) / chunk;
+    if (numChunks == 1) {
+        body(0, n);
+        return;
+    }
+    
+    // Shared with the helpers, which may only get to run after the loop has finished
+    struct Loop {
+        function<void(int, int)> body;
+        int n, chunk, numChunks;
+        atomic<int> next {0};
+        atomic<int> done {0};
+        mutex lock;
+        condition_variable finished;
+    };
+    shared_ptr<Loop> loop = make_shared<Loop>();
+    loop->body = body;
+    loop->n = n;
+    loop->chunk = chunk;
+    loop->numChunks = numChunks;
+    
+    auto run = [](Loop * l) {
+        int c;
+        while ((c = l->next.fetch_add(1)) < l->numChunks) {
+            l->body(c * l->chunk, min(l->n, (c + 1) * l->chunk));
+            if (l->done.fetch_add(1) + 1 == l->numChunks) {
+                lock_guard<mutex> guard(l->lock);
+                l->finished.notify_all();
+            }
+        }
+    };
+    
+    int helpers = min(size(), numChunks - 1);
+    for (int i = 0; i < helpers; i++) submit([loop, run] {run(loop.get());});
+    run(loop.get());
+    
+    unique_lock<mutex> guard(loop->lock);
+    loop->finished.wait(guard, [&] {return loop->done.load() == numChunks;});
+}
+
+void ThreadPool::work() {
+    while (true) {
+        function<void()> task;
+        {
+            unique_lock<mutex> guard(lock);
+            taskAdded.wait(guard, [this] {return stopping || !tasks.empty();});
+            if (tasks.empty()) return;  // Only when stopping
+            task = tasks.front();
+            tasks.pop();
+            busy++;
+        }
+        
+        task();
+        
+        {
+            unique_lock<mutex> guard(lock);
+            busy--;
+        }
+        taskDone.notify_all();
+    }
+}
@@ -0,0 +1,53 @@
+//
+//  threadpool.hpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#ifndef threadpool_hpp
+#define threadpool_hpp
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+
+using namespace std;
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+//      A fixed set of worker threads serving a first-in first-out
+//      queue of tasks. parallelFor splits a loop over the workers; its
+//      caller works on the loop too, so it can be used from inside a
+//      task without waiting on anything else in the queue.
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+class ThreadPool {
+public:
+    ThreadPool(int numThreads = 0);
+    ~ThreadPool();
+    void submit(function<void()> task);
+    void wait();
+    void parallelFor(int n, int chunk, function<void(int, int)> body);
+    int size() const {return (int)workers.size();}
+    
+private:
+    void work();
+    
+private:
+    vector<thread> workers;
+    queue<function<void()>> tasks;
+    mutex lock;
+    condition_variable taskAdded, taskDone;
+    int busy = 0;
+    bool stopping = false;
+};
+
+#endif /* threadpool_hpp */
@@ -0,0 +1,435 @@
+//
+//  tracker.cpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#include <algorithm>
+#include <cfloat>
+
+#include "tracker.hpp"
+#include "orange.hpp"
+#include "preprocess.hpp"
+#include "profiler.hpp"
+#include "region.hpp"
+#include "templates.hpp"
+
+
+// * * * * * * * * * * * * * * * * *
+//   LOCATE THE STARTING POSITIONS
+// * * * * * * * * * * * * * * * * *
+//      Match each object to its
+//      template bank, otherwise
+//      assume it is leaning back
+//      at ±45 degrees
+// * * * * * * * * * * * * * * * * *
+
+void Tracker::initialise(Mat frame, string templateFolder) {
+    // Finds the initial pose of each model, if none were given.
+    // templateFolder: where the template banks are kept (none are used if empty)
+    if (est.size() != 0) return;
+    initSources.clear();
+    
+    for (int m = 0; m < models.size(); m++) {
+        
+        if (!templateFolder.empty()) {
+            TemplateBank bank = TemplateBank::loadOrBuild(TemplateBank::pathFor(templateFolder, models[m], K), models[m], K);
+            Vec6f bankPose;
+            if (bank.initialPose(frame, models[m], K, bankPose)) {
+                est.push_back(estimate(bankPose, 0, 0));
+                initSources.push_back("template");
+                continue;
+            }
+        }
+        
+        // Find the area & centoid of the object in the image
+        Mat segInit = orange::segmentByColour(frame, models[m]->colour);
+        cvtColor(segInit, segInit, CV_BGR2GRAY);
+        threshold(segInit, segInit, 0, 255, CV_THRESH_BINARY);
+        Point centroid = ASM::getCentroid(segInit);
+        double area = ASM::getArea(segInit);
+        
+        // Draw the model at the default position and find the area & cetroid
+        Vec6f initPose = {0, 0, 300, -CV_PI/4, 0, 0};
+        Mat initGuess = Mat::zeros(frame.rows, frame.cols, frame.type());
+        models[m]->draw(initGuess, initPose, K, false);
+        cvtColor(initGuess, initGuess, CV_BGR2GRAY);
+        threshold(initGuess, initGuess, 0, 255, CV_THRESH_BINARY);
+        Point modelCentroid = ASM::getCentroid(initGuess);
+        double modelArea = ASM::getArea(initGuess);
+        
+        // Convert centroids to 3D/homogeneous coordinates
+        Mat centroid2D;
+        hconcat( Mat(centroid), Mat(modelCentroid), centroid2D );
+        vconcat(centroid2D, Mat::ones(1, 2, centroid2D.type()), centroid2D);
+        centroid2D.convertTo(centroid2D, K.type());
+        Mat centroid3D = K.inv() * centroid2D;
+        
+        // Estimate the depth from the ratio of the model and measured areas,
+        // and create a pose guess from that.
+        // Note that the x & y coordinates need to be calculated using the pose
+        // of the centroid relative to the synthetic model image's centroid.
+        double zGuess = initPose[2] * sqrt(modelArea/area);
+        centroid3D *= zGuess;
+        initPose[0] = centroid3D.at<float>(0, 0) - centroid3D.at<float>(0, 1);
+        initPose[1] = centroid3D.at<float>(1, 0) - centroid3D.at<float>(1, 1);
+        initPose[2] = zGuess;
+        
+        // Planar models: fit the corners to where the lines around the region meet
+        bool fromLines = useLineInit && !models[m]->is3D && linePose(m, segInit, initPose);
+        
+        // Set the intial pose
+        est.push_back(estimate(initPose, 0, 0));
+        initSources.push_back(fromLines ? "lines" : "centroid");
+    }
+    prevEst = est;
+}
+
+
+// * * * * * * * * * * * * * * * * *
+//   FRAME PROCESSING
+// * * * * * * * * * * * * * * * * *
+
+void Tracker::processFrame(Mat fullFrame) {
+    // Updates the pose estimates of all the models from the next frame.
+    // The frame itself is not modified.
+    auto frameStart = chrono::steady_clock::now();
+    stats = FrameStats();
+    
+    // Work at a lower resolution if asked; the poses are unaffected, only K is scaled
+    Mat frame = fullFrame;
+    Kwork = K;
+    traceScale = 1 << pyramidLevel;
+    if (pyramidLevel > 0) {
+        PROFILE_SCOPE(STAGE_PREPROCESS);
+        double s = 1.0 / traceScale;
+        resize(fullFrame, ctx.scaled, Size(), s, s, INTER_AREA);
+        frame = ctx.scaled;
+        Kwork = K.clone();
+        Mat focal = Kwork.rowRange(0, 2);
+        focal *= s;
+    }
+    
+    // Only the projected points are distorted, so the frame is used as it is
+    dist = NULL;
+    if (!distortion.empty() && countNonZero(distortion) > 0) {
+        if (lens.getSize() != frame.size() || lensLevel != pyramidLevel) {
+            lens = Distortion(Kwork, distortion, frame.size());
+            lensLevel = pyramidLevel;
+        }
+        dist = &lens;
+    }
+    
+    ctx.prepare(frame.size(), frame.type());
+    
+    if (useLineIter && useColourEdges) {
+        // Blur, detect and dilate the edges of each channel in one pass
+        PROFILE_SCOPE(STAGE_PREPROCESS);
+        preprocess::colourEdgeMap(frame, ctx.dilated, ctx.magnitude);
+    }
+    else if (useFusedEdges) {
+        // Blur, detect and dilate the edges in one pass
+        PROFILE_SCOPE(STAGE_PREPROCESS);
+        preprocess::edgeMap(frame, useLineIter ? ctx.dilated : ctx.canny, ctx.orientation, ctx.magnitude, useLineIter);
+        if (!useLineIter) findNonZero(ctx.canny, ctx.edgePoints);
+    }
+    else {
+        // Blur
+        {
+            PROFILE_SCOPE(STAGE_BLUR);
+            GaussianBlur(frame, ctx.blurred, Size(3,3), 1);
+        }
+        
+        // Detect edges
+        {
+            PROFILE_SCOPE(STAGE_CANNY);
+            Canny(ctx.blurred, ctx.canny, 20, 60);
+        }
+        
+        // Extract the image edge point coordinates
+        {
+            PROFILE_SCOPE(STAGE_DILATE);
+            if (!useLineIter) findNonZero(ctx.canny, ctx.edgePoints);
+            else dilate(ctx.canny, ctx.dilated, ctx.cross);
+        }
+        
+        // Gradient magnitudes for the sub-pixel refinement
+        if (useLineIter && subPixel) {
+            PROFILE_SCOPE(STAGE_PREPROCESS);
+            preprocess::gradientMagnitude(ctx.blurred, ctx.magnitude);
+        }
+    }
+    
+    // Edges for word-level whisker searches: packed once the whiskers show which copies they need
+    if (useLineIter && useBitEdges) ctx.bitEdges.setEdges(ctx.dilated);
+    
+    auto trackStart = chrono::steady_clock::now();
+    stats.preprocessTime = chrono::duration<double, milli>(trackStart - frameStart).count();
+    
+    // Find the pose of each model. Once past the deadline the rest keep their last
+    // pose, and go first next frame.
+    whiskerTrace.resize(models.size());
+    int numModels = (int)models.size();
+    int start = firstModel;
+    for (int i = 0; i < numModels; i++) {
+        int m = (start + i) % numModels;
+        if (i > 0 && chrono::steady_clock::now() > deadline) {
+            if (stats.skipped == 0) firstModel = m;
+            stats.skipped++;
+            if (traceWhiskers) whiskerTrace[m].clear();
+            continue;
+        }
+        if (colourWeight > 0 && !models[m]->is3D) {
+            // How far each pixel is from the model's colour
+            PROFILE_SCOPE(STAGE_SEGMENT);
+            orange::hueDistance(frame, models[m]->colour, ctx.hueDist, ctx.hueGradX, ctx.hueGradY);
+        }
+        trackModel(m);
+        if (useRegion && !models[m]->is3D) refineRegion(m, frame);
+    }
+    if (stats.skipped == 0) firstModel = 0;
+    stats.trackTime = chrono::duration<double, milli>(chrono::steady_clock::now() - trackStart).count();
+}
+
+Mat Tracker::interiorPoints(int m) {
+    // Points on a grid over a planar model that lie inside it (model coords, 4 x N).
+    // Found once, by drawing the model face-on and keeping the grid points it covers.
+    interior.resize(models.size());
+    if (!interior[m].empty()) return interior[m];
+    
+    Mat vertices = models[m]->pointsToMat();
+    double minX, maxX, minY, maxY;
+    minMaxLoc(vertices.row(0), &minX, &maxX);
+    minMaxLoc(vertices.row(1), &minY, &maxY);
+    
+    // A camera that fits the model into a 300x300 image
+    int size = 300;
+    float z = 1000;
+    float f = 0.8 * size * z / max(maxX - minX, maxY - minY);
+    Mat Kc = (Mat_<float>(3,3) << f, 0, size/2, 0, f, size/2, 0, 0, 1);
+    Vec6f pose = {(float)-(minX + maxX)/2, (float)-(minY + maxY)/2, z, 0, 0, 0};
+    Mat mask = Mat::zeros(size, size, CV_8UC3);
+    models[m]->draw(mask, pose, Kc, false);
+    cvtColor(mask, mask, CV_BGR2GRAY);
+    
+    Mat grid = Mat(4, 0, CV_32FC1);
+    for (int i = 0; i < INTERIOR_GRID; i++) {
+        for (int j = 0; j < INTERIOR_GRID; j++) {
+            float x = minX + (maxX - minX) * (i + 0.5) / INTERIOR_GRID;
+            float y = minY + (maxY - minY) * (j + 0.5) / INTERIOR_GRID;
+            Mat pt = (Mat_<float>(4,1) << x, y, 0, 1);
+            Mat proj = lsq::projection(pose, pt, Kc);
+            Point p = Point(proj.at<float>(0), proj.at<float>(1));
+            if (p.inside(Rect(0, 0, size, size)) && mask.at<uchar>(p) > 0) hconcat(grid, pt, grid);
+        }
+    }
+    interior[m] = grid;
+    return grid;
+}
+
+void Tracker::refineRegion(int m, Mat frame) {
+    // Pulls the model's outline onto the edge of its colour region. Only a window
+    // around the model is segmented, and its signed distance found.
+    Mat proj = lsq::projection(est[m].pose, models[m]->pointsToMat(), Kwork, dist);
+    Mat corners;
+    proj.rowRange(0, 2).convertTo(corners, CV_32S);
+    Rect window = boundingRect(corners.t());
+    window = Rect(window.x - region::MARGIN, window.y - region::MARGIN, window.width + 2*region::MARGIN, window.height + 2*region::MARGIN);
+    window &= Rect(0, 0, frame.cols, frame.rows);
+    if (window.area() == 0) return;
+    
+    Mat seg;
+    {
+        PROFILE_SCOPE(STAGE_SEGMENT);
+        seg = orange::segmentByColour(frame(window), models[m]->colour);
+    }
+    
+    PROFILE_SCOPE(STAGE_REGION);
+    if (!region::signedDistance(seg, ctx.regionDist, ctx.regionGradX, ctx.regionGradY)) return;
+    outline.resize(models.size());
+    if (outline[m].empty()) outline[m] = region::outlinePoints(models[m]);
+    
+    // K, with the window's corner as the origin
+    Mat Kwindow = Kwork.clone();
+    Kwindow.at<float>(0, 2) -= window.x;
+    Kwindow.at<float>(1, 2) -= window.y;
+    est[m].pose = region::refine(est[m].pose, outline[m], Kwindow, ctx.regionDist, ctx.regionGradX, ctx.regionGradY, region::MAX_ITERATIONS, dist).pose;
+}
+
+bool Tracker::linePose(int m, Mat seg, Vec6f & pose) const {
+    // Fits a planar model's corners to the corners of its segmented region, found as
+    // the meeting points of the strongest lines around it (one per edge of the model).
+    // pose: the rough pose to start from in, the fitted pose out (if it fits)
+    // Only suits convex outlines: other fits are rejected by their error.
+    Mat vertices = models[m]->pointsToMat();
+    int n = vertices.cols;
+    vector<Vec4i> lines = orange::borderLines(seg, n);
+    if ((int)lines.size() < n) return false;
+    
+    // Put the lines in order around the region
+    Point centre = ASM::getCentroid(seg);
+    auto angle = [centre](const Vec4i & l) {return atan2((l[1] + l[3])/2.0 - centre.y, (l[0] + l[2])/2.0 - centre.x);};
+    sort(lines.begin(), lines.end(), [&angle](const Vec4i & a, const Vec4i & b) {return angle(a) < angle(b);});
+    
+    // Where each line meets the next
+    Mat corners = Mat(n, 2, CV_32FC1);
+    for (int i = 0; i < n; i++) {
+        const Vec4i & a = lines[i];
+        const Vec4i & b = lines[(i + 1) % n];
+        Point2f da = Point2f(a[2] - a[0], a[3] - a[1]);
+        Point2f db = Point2f(b[2] - b[0], b[3] - b[1]);
+        float det = da.cross(db);
+        if (fabs(det) < 1e-3 * norm(da) * norm(db)) return false;
+        float t = (Point2f(b[0] - a[0], b[1] - a[1])).cross(db) / det;
+        corners.at<float>(i, 0) = a[0] + t * da.x;
+        corners.at<float>(i, 1) = a[1] + t * da.y;
+    }
+    
+    // Try each way round of matching the corners to the vertices
+    estimate best = estimate(pose, FLT_MAX, 0);
+    Mat target = Mat(n, 2, CV_32FC1);
+    for (int dir = -1; dir <= 1; dir += 2) {
+        for (int k = 0; k < n; k++) {
+            for (int i = 0; i < n; i++) corners.row(((k + dir*i) % n + n) % n).copyTo(target.row(i));
+            estimate e = lsq::poseEstimateLM(pose, vertices, target, K);
+            if (e.error < best.error) best = e;
+        }
+    }
+    if (best.error > LINE_INIT_ERROR) return false;
+    pose = best.pose;
+    return true;
+}
+
+Mat Tracker::getEdges() const {
+    // The edge map of the last frame, as 0 or 255
+    if (!useLineIter) return ctx.canny;
+    if (useColourEdges) return ctx.dilated > 0;
+    return ctx.dilated;
+}
+
+vector<Vec4i> Tracker::getWhiskerTrace() const {
+    // The whiskers (centre to matched edge) of every model's final iteration
+    // (in the frame's coordinates, even when tracking at a lower resolution)
+    vector<Vec4i> ret;
+    for (int m = 0; m < whiskerTrace.size(); m++) ret.insert(ret.end(), whiskerTrace[m].begin(), whiskerTrace[m].end());
+    for (int w = 0; w < ret.size(); w++) ret[w] *= traceScale;
+    return ret;
+}
+
+vector<EdgeCandidate> Tracker::searchWhisker(Whisker & whisker, bool soft) const {
+    // The edge(s) matched by one whisker. Only reads the frame's buffers, so
+    // whiskers can be searched in parallel.
+    if (soft) {
+        // Keep several candidates and let the solver weigh them up
+        return whisker.edgeCandidates(ctx.dilated, subPixel ? ctx.magnitude : Mat(), numCandidates);
+    }
+    
+    Point closestEdge;
+    if (!useLineIter) closestEdge = whisker.closestEdgePoint(ctx.edgePoints);
+    else if (useBitEdges) closestEdge = whisker.closestEdgePoint2(ctx.bitEdges);
+    else closestEdge = whisker.closestEdgePoint2(ctx.dilated);
+    if (closestEdge == Point(-1,-1)) return {};
+    
+    // Move the match onto the gradient peak
+    Point2f target = closestEdge;
+    if (useLineIter && subPixel) target = whisker.refineEdgePoint(closestEdge, ctx.magnitude);
+    return {EdgeCandidate(target, 1)};
+}
+
+void Tracker::trackModel(int m) {
+    // Predict the next pose: half of the last frame's motion again
+    SE3 pose = SE3::fromPose(est[m].pose);
+    SE3 velocity = pose * SE3::fromPose(prevEst[m].pose).inverse();
+    SE3 posePrediction = SE3::exp(0.5 * velocity.log()) * pose;
+    prevEst[m] = est[m];
+    est[m].pose = posePrediction.toPose();
+    
+    int iterations = 1;
+    double error = lsq::ERROR_THRESHOLD + 1;
+    while (error > lsq::ERROR_THRESHOLD && iterations < maxIterations) {
+        // Out of time: keep what we have (but always make one attempt)
+        if (iterations > 1 && chrono::steady_clock::now() > deadline) break;
+        
+        // Generate a set of whiskers (spaced as at full resolution). 3D models are divided up
+        // by their projected edge lengths, planar ones by their lengths on the model, which
+        // don't change with the pyramid level.
+        vector<Whisker> whiskers;
+        {
+            PROFILE_SCOPE(STAGE_WHISKERS);
+            double spacing = models[m]->is3D ? whiskerSpacing / traceScale : whiskerSpacing;
+            whiskers = ASM::projectToWhiskers(models[m], est[m].pose, Kwork, spacing, dist);
+        }
+        stats.whiskers += whiskers.size();
+        stats.iterations++;
+        if (!models[m]->is3D) {
+            stats.planarWhiskers += whiskers.size();
+            stats.planarIterations++;
+        }
+        
+        if (traceWhiskers) whiskerTrace[m].clear();
+        
+        // Sample along the model edges and find the edges that intersect each whisker.
+        // The whiskers are searched in parallel chunks (if there is a pool), then
+        // their matches are gathered in whisker order.
+        bool soft = useLineIter && numCandidates > 1;
+        ctx.reserveWhiskers((int)whiskers.size() * (soft ? numCandidates : 1));
+        ctx.targetWhisker.clear();
+        int numMatches = 0;
+        if (useLineIter && useBitEdges && !soft) {
+            // Pack just the copies of the edges that these whiskers scan (before searching in parallel)
+            PROFILE_SCOPE(STAGE_PREPROCESS);
+            bool rows = false, cols = false;
+            for (int w = 0; w < whiskers.size(); w++) (whiskers[w].searchesRows() ? rows : cols) = true;
+            ctx.bitEdges.require(rows, cols);
+        }
+        {
+            PROFILE_SCOPE(STAGE_EDGE_SEARCH);
+            ctx.whiskerHits.resize(whiskers.size());
+            auto search = [&](int begin, int end) {
+                for (int w = begin; w < end; w++) ctx.whiskerHits[w] = searchWhisker(whiskers[w], soft);
+            };
+            if (pool != NULL && whiskers.size() > WHISKER_CHUNK) pool->parallelFor((int)whiskers.size(), WHISKER_CHUNK, search);
+            else search(0, (int)whiskers.size());
+            
+            for (int w = 0; w < whiskers.size(); w++) {
+                vector<EdgeCandidate> & hits = ctx.whiskerHits[w];
+                for (int c = 0; c < hits.size(); c++) {
+                    whiskers[w].modelCentre.copyTo(ctx.whiskerModel.col(numMatches));
+                    ctx.targetPoints.at<float>(numMatches, 0) = hits[c].point.x;
+                    ctx.targetPoints.at<float>(numMatches, 1) = hits[c].point.y;
+                    ctx.targetPrior.at<float>(numMatches) = hits[c].score;
+                    ctx.targetWhisker.push_back(w);
+                    numMatches++;
+                }
+                
+                //TRACE: Keep the whiskers (to the best match) for the display
+                if (traceWhiskers && !hits.empty()) whiskerTrace[m].push_back(Vec4i(whiskers[w].centre.x, whiskers[w].centre.y, cvRound(hits[0].point.x), cvRound(hits[0].point.y)));
+            }
+        }
+        
+        // Catch error where no points are found
+        if (numMatches == 0) break;
+        
+        // Use least squares to match the sampled edges to each other
+        {
+            PROFILE_SCOPE(STAGE_SOLVE);
+            if (soft) est[m] = lsq::poseEstimateSoft(est[m].pose, ctx.whiskerModel.colRange(0, numMatches), ctx.targetPoints.rowRange(0, numMatches),
+                                                     ctx.targetPrior.rowRange(0, numMatches), ctx.targetWhisker, Kwork, SOFT_ITERATIONS, dist);
+            else if (colourWeight > 0 && !models[m]->is3D && interiorPoints(m).cols > 0) {
+                est[m] = lsq::poseEstimateLM(est[m].pose, ctx.whiskerModel.colRange(0, numMatches), ctx.targetPoints.rowRange(0, numMatches), Kwork,
+                                             ctx.hueDist, ctx.hueGradX, ctx.hueGradY, interiorPoints(m), colourWeight, solverIterations, dist);
+            }
+            else est[m] = lsq::poseEstimateLM(est[m].pose, ctx.whiskerModel.colRange(0, numMatches), ctx.targetPoints.rowRange(0, numMatches), Kwork, solverIterations, pool, dist);
+        }
+        
+        double improvement = (error - est[m].error)/error;
+        error = est[m].error;
+        
+        // Stop trying if you reduce the error by < 1% (excl. the first one)
+        if (improvement < 0.01 && iterations > 1) break;
+        
+        iterations++;
+    }
+}
@@ -0,0 +1,118 @@
+//
+//  tracker.hpp
+//  EdgeTracker
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#ifndef tracker_hpp
+#define tracker_hpp
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <chrono>
+#include <iostream>
+#include <stdio.h>
+
+#include "asm.hpp"
+#include "distortion.hpp"
+#include "framecontext.hpp"
+#include "lsq.hpp"
+#include "models.hpp"
+#include "threadpool.hpp"
+
+using namespace std;
+using namespace cv;
+
+
+// * * * * * * * * * * * * * * *
+//      FrameStats
+// * * * * * * * * * * * * * * *
+
+class FrameStats {
+public:
+    double preprocessTime = 0;  // Edge detection (ms)
+    double trackTime = 0;       // Whisker search and pose solving, all models (ms)
+    int whiskers = 0;           // Whiskers searched, over all models and iterations
+    int iterations = 0;         // Whisker projections, over all models
+    int planarWhiskers = 0;     // The share of those of planar models
+    int planarIterations = 0;
+    int skipped = 0;            // Models left unrefined to meet the deadline
+};
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+//      Tracks a set of models through the frames of one video stream.
+//      The models are only read, so they may be shared between trackers.
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+class Tracker {
+public:
+    Tracker(vector<const Model *> models_in, Mat K_in, vector<estimate> est_in = {}) : models(models_in), K(K_in), est(est_in), prevEst(est_in) {}
+    void initialise(Mat frame, string templateFolder = "");
+    void processFrame(Mat frame);
+    vector<estimate> getEstimates() const {return est;}
+    vector<string> getInitSources() const {return initSources;}
+    vector<const Model *> getModels() const {return models;}
+    Mat getK() const {return K;}
+    Mat getEdges() const;
+    vector<Vec4i> getWhiskerTrace() const;
+    FrameStats getStats() const {return stats;}
+    
+public:
+    bool useLineIter = true;    // Whether to use the line iterator technique for the whiskers
+    bool useFusedEdges = true;  // Whether to find the edges in one fused pass over the luma (see preprocess.hpp)
+    bool useColourEdges = false;// Whether to use the edges of every colour channel, packed together (line iterator only)
+    bool useBitEdges = false;   // Whether to search a bit-packed copy of the edges (line iterator only)
+    bool subPixel = true;       // Whether to refine the whisker matches to sub-pixel precision (line iterator only)
+    int numCandidates = 1;      // Edges kept per whisker; more than 1 weights them softly (line iterator only)
+    float colourWeight = 0;     // Weight (0-1) of the colour term in the solver; 0 uses the edges alone (planar models only)
+    bool useRegion = false;     // Whether to pull each model's outline onto its colour region after the edges (planar models only)
+    bool useLineInit = false;   // Whether to start planar models from the lines around their colour regions (if no template matches)
+    bool traceWhiskers = false; // Whether to keep the matched whiskers, for display
+    ThreadPool * pool = NULL;   // Workers to share each model's whisker search and solve with (none: serial)
+    Mat distortion;             // Lens distortion coefficients (k1, k2, p1, p2[, k3]) of K; empty: none
+    
+    // Cost controls (see budget.hpp)
+    double whiskerSpacing = ASM::WHISKER_SPACING;   // Between whiskers along the edges (px at full resolution; model units for planar models)
+    int maxIterations = MAX_ITERATIONS;             // Max no. of whisker projections per model per frame
+    int solverIterations = 2;                       // Max no. of solver steps per projection
+    int pyramidLevel = 0;                           // Track at 1/2^level of the frame's resolution
+    chrono::steady_clock::time_point deadline = chrono::steady_clock::time_point::max(); // No more refinement after this
+    
+private:
+    void trackModel(int m);
+    vector<EdgeCandidate> searchWhisker(Whisker & whisker, bool soft) const;
+    Mat interiorPoints(int m);
+    void refineRegion(int m, Mat frame);
+    bool linePose(int m, Mat seg, Vec6f & pose) const;
+    
+private:
+    vector<const Model *> models;
+    Mat K;
+    vector<estimate> est, prevEst;
+    vector<string> initSources;             // Per model: how initialise found its pose ("template", "lines" or "centroid")
+    FrameContext ctx;                       // Buffers reused from frame to frame
+    vector<vector<Vec4i>> whiskerTrace;     // Per model: (centre x, y, edge x, y) of each matched whisker
+    vector<Mat> interior;                   // Per model: points inside it, for the colour term (empty until used)
+    vector<Mat> outline;                    // Per model: points around its outline, for the region refinement (empty until used)
+    Mat Kwork;                              // K at the resolution being tracked at
+    int traceScale = 1;                     // Scale from that resolution to the frame's
+    Distortion lens;                        // The distortion at that resolution (rebuilt when it changes)
+    int lensLevel = 0;                      // The pyramid level the lens was built for
+    const Distortion * dist = NULL;         // The lens, if there is any distortion
+    int firstModel = 0;                     // Model to refine first (the first one skipped last frame)
+    FrameStats stats;
+    
+/*
+ CONSTANTS
+ */
+public:
+    static const int MAX_ITERATIONS = 20;   // Max no. of whisker projections per model per frame
+    static const int INTERIOR_GRID = 8;     // Colour term: interior points sampled on a grid of this size
+    static const int WHISKER_CHUNK = 32;    // Whiskers per task when searching in parallel
+    static const int SOFT_ITERATIONS = 8;   // Max no. of reweighting steps per projection (multiple candidates only)
+    static constexpr float LINE_INIT_ERROR = 16;    // Line initialisation: largest mean square error (px^2) at the corners of a pose kept
+};
+
+#endif /* tracker_hpp */
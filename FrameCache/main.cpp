@@ -0,0 +1,55 @@
+//
+//  main.cpp
+//  FrameCache
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#include <chrono>
+#include <iostream>
+#include <stdlib.h>
+
+#include "../EdgeTracker/framecache.hpp"
+
+using namespace std;
+
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+//      Decodes a video once into a frame cache, which the
+//      trackers can replay from memory (source cache:<path>).
+//
+//      Usage: FrameCache <video> [out.etframes] [max frames]
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+int main(int argc, const char * argv[]) {
+    if (argc < 2) {
+        cout << "Usage: FrameCache <video> [out.etframes] [max frames]" << endl;
+        return -1;
+    }
+    string in = argv[1];
+    string out = (argc > 2) ? argv[2] : FrameCache::pathFor(in);
+    int maxFrames = (argc > 3) ? atoi(argv[3]) : 0;
+    
+    auto start = chrono::steady_clock::now();
+    if (!FrameCache::build(in, out, maxFrames)) {
+        cout << "Could not cache " << in << endl;
+        return -1;
+    }
+    chrono::duration<double> time = chrono::steady_clock::now() - start;
+    
+    // Read it back, to check it
+    MappedFrameSource cache(out);
+    if (!cache.isOpened()) {
+        cout << "Could not read back " << out << endl;
+        return -1;
+    }
+    
+    Size size = cache.getSize();
+    double megabytes = (double)cache.getFrameCount() * size.area() * 3 / (1 << 20);
+    cout << "Wrote " << out << endl;
+    cout << "Frames       = " << cache.getFrameCount() << " (" << size.width << "x" << size.height << ", " << cache.getFps() << " fps)" << endl;
+    cout << "Size         = " << megabytes << " MB" << endl;
+    cout << "Decode time  = " << 1000.0 * time.count() / cache.getFrameCount() << " ms per frame" << endl;
+    
+    return 0;
+}
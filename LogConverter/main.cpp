@@ -0,0 +1,37 @@
+//
+//  main.cpp
+//  LogConverter
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#include <iostream>
+
+#include "../EdgeTracker/logger.hpp"
+
+using namespace std;
+
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+//      Converts a binary pose log to the semicolon-
+//      separated CSV layout of the old logs.
+//
+//      Usage: LogConverter <log.etlog> [out.csv]
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+int main(int argc, const char * argv[]) {
+    if (argc < 2) {
+        cout << "Usage: LogConverter <log.etlog> [out.csv]" << endl;
+        return -1;
+    }
+    string in = argv[1];
+    string out = (argc > 2) ? argv[2] : in.substr(0, in.find_last_of('.')) + ".csv";
+    
+    if (!PoseLogger::toCSV(in, out)) {
+        cout << "Could not convert " << in << endl;
+        return -1;
+    }
+    cout << "Wrote " << out << endl;
+    
+    return 0;
+}
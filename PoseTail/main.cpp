@@ -0,0 +1,81 @@
+//
+//  main.cpp
+//  PoseTail
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#include <chrono>
+#include <iostream>
+#include <string.h>
+#include <thread>
+
+#include "../EdgeTracker/telemetry.hpp"
+
+using namespace std;
+
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+//      Follows the poses published by a tracker (see
+//      telemetry.hpp) and prints each as it arrives, with
+//      its age when read, until the tracker stops.
+//
+//      Usage: PoseTail [name] [-a]
+//
+//      -a starts from the oldest record still in the ring
+//      rather than the newest.
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+int main(int argc, const char * argv[]) {
+    string name = TelemetryPublisher::DEFAULT_NAME;
+    bool fromOldest = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-a") == 0) fromOldest = true;
+        else if (argv[i][0] == '/') name = argv[i];
+        else {
+            cout << "Usage: PoseTail [name] [-a]" << endl;
+            return -1;
+        }
+    }
+    
+    // Wait for the tracker to start publishing
+    TelemetryReader reader;
+    if (!reader.open(name)) {
+        cout << "Waiting for " << name << "..." << endl;
+        while (!reader.open(name)) this_thread::sleep_for(chrono::milliseconds(100));
+    }
+    if (!fromOldest) reader.skipToEnd();
+    
+    printf("%8s %6s %5s %8s %8s %8s %7s %7s %7s %7s %7s %7s %8s\n",
+           "Seq", "Frame", "Model", "x", "y", "z", "rx", "ry", "rz", "Error", "Time", "Latency", "Age (us)");
+    long long count = 0;
+    double totalAge = 0, worstAge = 0;
+    TelemetryRecord r;
+    while (true) {
+        if (!reader.next(r)) {
+            if (reader.ended()) break;
+            this_thread::sleep_for(chrono::microseconds(50));
+            continue;
+        }
+        
+        // Time from publishing to here (the clocks are the same in every process)
+        int64_t now = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+        double age = (now - r.timestamp) / 1000.0;
+        count++;
+        totalAge += age;
+        worstAge = max(worstAge, age);
+        
+        printf("%8llu %6i %5i %8.1f %8.1f %8.1f %7.3f %7.3f %7.3f %7.3f %7.2f %7.2f %8.1f\n", (unsigned long long)r.sequence,
+               r.frame, r.model, r.pose[0], r.pose[1], r.pose[2], r.pose[3], r.pose[4], r.pose[5], r.errorArea, r.time, r.latency, age);
+    }
+    
+    cout << endl;
+    cout << "Records      = " << count << endl;
+    cout << "Lost         = " << reader.getLost() << endl;
+    if (count > 0) {
+        cout << "Avg age      = " << totalAge / count << " us" << endl;
+        cout << "Oldest       = " << worstAge << " us" << endl;
+    }
+    
+    return 0;
+}
@@ -0,0 +1,157 @@
+//
+//  main.cpp
+//  SceneGenerator
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/videoio/videoio.hpp>
+#include <fstream>
+#include <iostream>
+#include <stdlib.h>
+
+#include "../EdgeTracker/synthetic.hpp"
+
+using namespace std;
+using namespace cv;
+
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+//      Renders a synthetic sequence with its ground truth, for
+//      offline speed and accuracy evaluation.
+//
+//      Usage: SceneGenerator <output prefix> [options]
+//          -c <scene.yml>  Scene file (see synthetic.hpp)
+//          -n <n>          Add n objects on random trajectories  (1)
+//          -s <WxH>        Frame size                             (1280x720)
+//          -f <n>          No. of frames                          (300)
+//          -noise <s>      Pixel noise std. dev.                  (0)
+//          -blur <s>       Blur std. dev. in pixels               (0)
+//          -clutter <n>    No. of background distractors          (0)
+//          -occluders <n>  No. of moving occluders                (0)
+//          -avi            Write an MJPG .avi instead of raw frames
+//
+//      Writes:
+//          <prefix>.raw / .avi     The frames (raw: back-to-back BGR)
+//          <prefix>_truth.csv      The true pose of every object in every frame
+//          <prefix>.yml            A TrackerServer config for the sequence,
+//                                  starting from the true first poses
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+int main(int argc, const char * argv[]) {
+    if (argc < 2) {
+        cout << "Usage: SceneGenerator <output prefix> [-c scene.yml] [-n objects] [-s WxH] [-f frames]" << endl;
+        cout << "                      [-noise s] [-blur s] [-clutter n] [-occluders n] [-avi]" << endl;
+        return -1;
+    }
+    string prefix = argv[1];
+    
+    // Read the options
+    string sceneFile = "";
+    int numRandom = -1, numFrames = 300;
+    Size size = Size(0, 0);     // Unset: from the scene file, else 1280x720
+    double noise = -1, blur = -1;
+    int clutter = -1, occluders = -1;
+    bool avi = false;
+    for (int i = 2; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "-avi") {
+            avi = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            cout << "Missing value for " << arg << endl;
+            return -1;
+        }
+        string value = argv[++i];
+        if (arg == "-c") sceneFile = value;
+        else if (arg == "-n") numRandom = stoi(value);
+        else if (arg == "-s") size = Size(stoi(value), stoi(value.substr(value.find('x') + 1)));
+        else if (arg == "-f") numFrames = stoi(value);
+        else if (arg == "-noise") noise = stod(value);
+        else if (arg == "-blur") blur = stod(value);
+        else if (arg == "-clutter") clutter = stoi(value);
+        else if (arg == "-occluders") occluders = stoi(value);
+        else {
+            cout << "Unknown option " << arg << endl;
+            return -1;
+        }
+    }
+    
+    // Build the scene; the image settings on the command line override the scene file
+    SyntheticScene scene = SyntheticScene(Size(1280, 720));
+    if (!sceneFile.empty() && !scene.loadConfig(sceneFile)) return -1;
+    if (size.area() > 0) scene.setSize(size);
+    if (numRandom > 0 || (sceneFile.empty() && numRandom < 0)) scene.addRandomObjects(max(numRandom, 1));
+    if (noise >= 0) scene.noise = noise;
+    if (blur >= 0) scene.blur = blur;
+    if (clutter >= 0) scene.clutter = clutter;
+    if (occluders >= 0) scene.occluders = occluders;
+    size = scene.getSize();
+    
+    vector<const Model *> models = scene.getModels();
+    if (models.empty()) {
+        cout << "The scene has no objects" << endl;
+        return -1;
+    }
+    
+    // Open the outputs
+    string framesPath = prefix + (avi ? ".avi" : ".raw");
+    VideoWriter video;
+    FILE * raw = NULL;
+    if (avi) video.open(framesPath, VideoWriter::fourcc('M','J','P','G'), 30, size);
+    else raw = fopen(framesPath.c_str(), "wb");
+    if (!(avi ? video.isOpened() : raw != NULL)) {
+        cout << "Could not open " << framesPath << endl;
+        return -1;
+    }
+    
+    ofstream truth(prefix + "_truth.csv");
+    truth << "Frame,Object,Model,X,Y,Z,RX,RY,RZ" << endl;
+    
+    // Render
+    Mat frame;
+    vector<Vec6f> poses;
+    for (int f = 0; f < numFrames; f++) {
+        scene.render(f, frame, poses);
+        if (avi) video << frame;
+        else fwrite(frame.data, 1, frame.total() * frame.elemSize(), raw);
+        
+        for (int m = 0; m < poses.size(); m++) {
+            truth << f << "," << m << "," << models[m]->name;
+            for (int p = 0; p < 6; p++) truth << "," << poses[m][p];
+            truth << "\n";
+        }
+    }
+    truth.close();
+    if (raw != NULL) fclose(raw);
+    
+    // A stream config, so that the sequence can be tracked straight away
+    Mat K = scene.getK();
+    vector<Vec6f> start = scene.posesAt(0);
+    FileStorage fs(prefix + ".yml", FileStorage::WRITE);
+    fs << "streams" << "[";
+    fs << "{:" << "name" << prefix.substr(prefix.find_last_of('/') + 1)
+       << "source" << (avi ? framesPath : "raw:" + framesPath)
+       << "width" << size.width << "height" << size.height
+       << "fx" << K.at<float>(0, 0) << "fy" << K.at<float>(1, 1)
+       << "cx" << K.at<float>(0, 2) << "cy" << K.at<float>(1, 2);
+    fs << "models" << "[:";
+    for (int m = 0; m < models.size(); m++) fs << models[m]->name;
+    fs << "]";
+    fs << "poses" << "[";
+    for (int m = 0; m < start.size(); m++) {
+        fs << "[:";
+        for (int p = 0; p < 6; p++) fs << start[m][p];
+        fs << "]";
+    }
+    fs << "]" << "}";
+    fs << "]";
+    fs.release();
+    
+    cout << "Wrote " << numFrames << " frames of " << models.size() << " objects at "
+         << size.width << "x" << size.height << " to " << framesPath << endl;
+    
+    return 0;
+}
@@ -0,0 +1,172 @@
+//
+//  main.cpp
+//  SweepRunner
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#include <opencv2/core/core.hpp>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <stdlib.h>
+
+#include "../EdgeTracker/area.hpp"
+#include "../EdgeTracker/framecache.hpp"
+#include "../EdgeTracker/orange.hpp"
+#include "../EdgeTracker/scenarios.hpp"
+#include "../EdgeTracker/templates.hpp"
+#include "../EdgeTracker/threadpool.hpp"
+#include "../EdgeTracker/tracker.hpp"
+
+using namespace std;
+using namespace cv;
+
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+//      Tracks every scenario in the catalogue without any
+//      display, one sequence per worker, and reports the
+//      speed and area error of each and of the whole sweep.
+//
+//      Usage: SweepRunner <scenarios.yml> [workers] [report.csv]
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+class SweepResult {
+public:
+    string name;
+    bool ran = false;
+    int frames = 0;
+    double totalTime = 0;       // Tracking only (ms)
+    double worstTime = 0;       // ms
+    double totalError = 0;      // Sum of the area errors, over all models and frames
+    double worstError = 0;
+    int errors = 0;             // No. of area errors measured
+};
+
+static void runScenario(const Scenario & scenario, const ScenarioCatalogue & catalogue, SweepResult & result) {
+    // Tracks one sequence to its end, measuring the area error of every model in every frame
+    result.name = scenario.name;
+    
+    // Replay the sequence's frame cache if it has one (see FrameCache)
+    string videoPath = catalogue.dataFolder + scenario.name + ".avi";
+    string cachePath = FrameCache::pathFor(videoPath);
+    unique_ptr<FrameSource> source(FrameSource::open(ifstream(cachePath).good() ? "cache:" + cachePath : videoPath));
+    if (!source) return;
+    Mat frame;
+    if (!source->read(frame)) return;
+    
+    vector<const Model *> models = scenario.modelPointers();
+    Tracker tracker = Tracker(models, catalogue.K, scenario.est);
+    tracker.initialise(frame, catalogue.templateFolder);
+    result.ran = true;
+    
+    while (!frame.empty()) {
+        auto start = chrono::steady_clock::now();
+        tracker.processFrame(frame);
+        chrono::duration<double, milli> time = chrono::steady_clock::now() - start;
+        result.frames++;
+        result.totalTime += time.count();
+        result.worstTime = max(result.worstTime, time.count());
+        
+        vector<estimate> est = tracker.getEstimates();
+        for (int m = 0; m < models.size(); m++) {
+            Mat seg = orange::segmentByColour(frame, models[m]->colour);
+            double error = models[m]->is3D ? area::areaError(est[m].pose, models[m], seg, catalogue.K)
+                                           : area::areaError(est[m].pose, models[m], area::outline(seg), catalogue.K);
+            result.totalError += error;
+            result.worstError = max(result.worstError, error);
+            result.errors++;
+        }
+        
+        if (!source->read(frame)) frame = Mat();
+    }
+}
+
+int main(int argc, const char * argv[]) {
+    if (argc < 2) {
+        cout << "Usage: SweepRunner <scenarios.yml> [workers] [report.csv]" << endl;
+        return -1;
+    }
+    int numWorkers = (argc > 2) ? atoi(argv[2]) : 0;
+    string reportPath = (argc > 3) ? argv[3] : "";
+    
+    ScenarioCatalogue catalogue;
+    if (!catalogue.load(argv[1])) return -1;
+    if (catalogue.K.empty()) {
+        cout << argv[1] << ": no intrinsics (fx, fy, cx, cy)" << endl;
+        return -1;
+    }
+    
+    // Each sequence has a core to itself, so OpenCV should not spread out any further
+    setNumThreads(1);
+    
+    // Build any missing template banks first, so the sequences only ever read them
+    if (!catalogue.templateFolder.empty()) {
+        set<string> built;
+        for (const Scenario & scenario : catalogue.scenarios) {
+            if (!scenario.est.empty()) continue;
+            for (const Model * model : scenario.modelPointers()) {
+                if (!built.insert(model->name).second) continue;
+                TemplateBank::loadOrBuild(TemplateBank::pathFor(catalogue.templateFolder, model, catalogue.K), model, catalogue.K);
+            }
+        }
+    }
+    
+    // One task per sequence; each writes only its own result
+    vector<SweepResult> results(catalogue.scenarios.size());
+    auto sweepStart = chrono::steady_clock::now();
+    {
+        ThreadPool pool(numWorkers);
+        for (int s = 0; s < catalogue.scenarios.size(); s++) {
+            pool.submit([&, s] {runScenario(catalogue.scenarios[s], catalogue, results[s]);});
+        }
+        pool.wait();
+    }
+    chrono::duration<double> sweepTime = chrono::steady_clock::now() - sweepStart;
+    
+    // Report each sequence, then the whole sweep
+    printf("%-26s %7s %9s %8s %9s %8s %8s\n", "Scenario", "Frames", "Mean ms", "fps", "Worst ms", "Error", "Worst");
+    int ran = 0, frames = 0, errors = 0;
+    double totalTime = 0, totalError = 0, worstTime = 0, worstError = 0;
+    for (const SweepResult & r : results) {
+        if (!r.ran) {
+            printf("%-26s %7s\n", r.name.c_str(), "missing");
+            continue;
+        }
+        double meanTime = r.totalTime / max(r.frames, 1);
+        double meanError = r.totalError / max(r.errors, 1);
+        printf("%-26s %7i %9.2f %8.1f %9.2f %8.3f %8.3f\n", r.name.c_str(), r.frames, meanTime, 1000.0 / meanTime, r.worstTime, meanError, r.worstError);
+        ran++;
+        frames += r.frames;
+        errors += r.errors;
+        totalTime += r.totalTime;
+        totalError += r.totalError;
+        worstTime = max(worstTime, r.worstTime);
+        worstError = max(worstError, r.worstError);
+    }
+    
+    double meanTime = totalTime / max(frames, 1);
+    cout << endl;
+    cout << "Scenarios    = " << ran << " of " << results.size() << endl;
+    cout << "No. frames   = " << frames << endl;
+    cout << "Avg time     = " << meanTime << " ms     " << 1000.0/meanTime << " fps" << endl;
+    cout << "Longest time = " << worstTime << " ms" << endl;
+    cout << "Avg error    = " << totalError / max(errors, 1) << endl;
+    cout << "Worst error  = " << worstError << endl;
+    cout << "Sweep time   = " << sweepTime.count() << " s" << endl;
+    
+    if (!reportPath.empty()) {
+        ofstream csv(reportPath);
+        csv << "Scenario;Frames;Mean time (ms);Worst time (ms);Mean error;Worst error" << endl;
+        for (const SweepResult & r : results) {
+            if (!r.ran) continue;
+            csv << r.name << ";" << r.frames << ";" << r.totalTime / max(r.frames, 1) << ";" << r.worstTime << ";"
+                << r.totalError / max(r.errors, 1) << ";" << r.worstError << endl;
+        }
+        cout << "Wrote " << reportPath << endl;
+    }
+    
+    return 0;
+}
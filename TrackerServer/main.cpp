@@ -0,0 +1,44 @@
+//
+//  main.cpp
+//  TrackerServer
+//
+//  Created by Daniel Mesham on 18/10/2026.
+//  Copyright © 2026 Daniel Mesham. All rights reserved.
+//
+
+#include <iostream>
+#include <stdlib.h>
+
+#include "../EdgeTracker/profiler.hpp"
+#include "../EdgeTracker/streams.hpp"
+
+using namespace std;
+
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+//      Tracks every stream in a config file on a shared
+//      pool of workers, then reports per-stream latency.
+//
+//      Usage: TrackerServer <config.yml> [workers]
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+int main(int argc, const char * argv[]) {
+    if (argc < 2) {
+        cout << "Usage: TrackerServer <config.yml> [workers]" << endl;
+        return -1;
+    }
+    int numWorkers = (argc > 2) ? atoi(argv[2]) : 0;
+    
+    StreamServer server(numWorkers);
+    if (!server.loadConfig(argv[1])) return -1;
+    
+    server.run();
+    server.report();
+    
+#ifdef PROFILING
+    cout << endl;
+    Profiler::report();
+    Profiler::writeTrace("TrackerServer_trace.json");
+#endif
+    
+    return 0;
+}